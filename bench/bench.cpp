@@ -0,0 +1,610 @@
+
+// Microbenchmarks for every ArrayView x ComputeBuilder pair over the
+// files in inst/example_feather. Each input is read once for every operation
+// (cast to each encoding of the same geometry type, global_bounds,
+// geoparquet_types, feature_stats, and void, which measures the cost of
+// reading alone) and optionally scaled up by reading the same arrays into a
+// single builder more than once. Synthetic inputs of any size can be
+// generated as well (see synthetic.hpp). See README.md for usage.
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <dirent.h>
+#include <algorithm>
+#include <memory>
+#include <new>
+#include <string>
+#include <vector>
+
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+#define GEOARROW_ENDIAN 0x00
+#else
+#define GEOARROW_ENDIAN 0x01
+#endif
+
+#define FASTFLOAT_ASSERT(x)
+#include "internal/fast_float/fast_float.h"
+
+#include "ryu/ryu.h"
+#define geoarrow_d2s_fixed_n geoarrow_d2sfixed_buffered_n
+
+// For implementations of release callbacks
+#define ARROW_HPP_IMPL
+
+#include "geoarrow.h"
+#include "synthetic.hpp"
+
+// Allocation counting --------------------------------------------------------
+
+static int64_t n_allocations = 0;
+
+// With GNU ld, the Makefile links with --wrap=malloc (etc.) such that calls to
+// malloc() from the headers (i.e., the arrow-hpp builders) are counted.
+// Elsewhere only calls to operator new are counted.
+#if defined(GEOARROW_BENCH_WRAP_MALLOC)
+
+extern "C" void* __real_malloc(size_t size);
+extern "C" void* __real_calloc(size_t n, size_t size);
+extern "C" void* __real_realloc(void* ptr, size_t size);
+
+extern "C" void* __wrap_malloc(size_t size) {
+    n_allocations++;
+    return __real_malloc(size);
+}
+
+extern "C" void* __wrap_calloc(size_t n, size_t size) {
+    n_allocations++;
+    return __real_calloc(n, size);
+}
+
+extern "C" void* __wrap_realloc(void* ptr, size_t size) {
+    n_allocations++;
+    return __real_realloc(ptr, size);
+}
+
+// malloc() is already counted by __wrap_malloc()
+static void* bench_operator_new(size_t size) {
+    return malloc(size == 0 ? 1 : size);
+}
+
+#else
+
+static void* bench_operator_new(size_t size) {
+    n_allocations++;
+    return malloc(size == 0 ? 1 : size);
+}
+
+#endif
+
+// Every form of operator new/delete is replaced such that memory from any
+// of them is allocated with malloc() and released with free(). The delete
+// operators are not inlined such that the compiler doesn't see free() called
+// directly on the result of operator new (-Wmismatched-new-delete).
+#if defined(__GNUC__)
+#define BENCH_NOINLINE __attribute__((noinline))
+#else
+#define BENCH_NOINLINE
+#endif
+
+void* operator new(size_t size) {
+    void* ptr = bench_operator_new(size);
+    if (ptr == nullptr) {
+        throw std::bad_alloc();
+    }
+
+    return ptr;
+}
+
+void* operator new[](size_t size) {
+    return operator new(size);
+}
+
+void* operator new(size_t size, const std::nothrow_t&) noexcept {
+    return bench_operator_new(size);
+}
+
+void* operator new[](size_t size, const std::nothrow_t&) noexcept {
+    return bench_operator_new(size);
+}
+
+BENCH_NOINLINE void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void* ptr) noexcept {
+    free(ptr);
+}
+
+BENCH_NOINLINE void operator delete(void* ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void* ptr, const std::nothrow_t&) noexcept {
+    free(ptr);
+}
+
+#if defined(__cpp_sized_deallocation)
+
+BENCH_NOINLINE void operator delete(void* ptr, size_t size) noexcept {
+    free(ptr);
+}
+
+BENCH_NOINLINE void operator delete[](void* ptr, size_t size) noexcept {
+    free(ptr);
+}
+
+#endif
+
+// Inputs ---------------------------------------------------------------------
+
+// Counts the features and coordinates of an input once such that the timed
+// runs can report throughput
+class VertexCounter: public geoarrow::Handler {
+public:
+    VertexCounter(): n_vertices(0) {}
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        n_vertices += n;
+        return Result::CONTINUE;
+    }
+
+    int64_t n_vertices;
+};
+
+// The number of bytes referenced by an array's buffers (i.e., the bytes a
+// view has to read), ignoring any part of a child array that is not
+// referenced by its parent's offsets
+static int64_t array_bytes(const struct ArrowSchema* schema, const struct ArrowArray* array) {
+    int64_t n = array->offset + array->length;
+    const char* format = schema->format;
+    int64_t bytes = 0;
+
+    if (schema->dictionary != nullptr) {
+        bytes += array_bytes(schema->dictionary, array->dictionary);
+    }
+
+    // Unions have no validity buffer
+    if (strncmp(format, "+ud:", 4) == 0) {
+        bytes += n * (sizeof(int8_t) + sizeof(int32_t));
+        for (int64_t i = 0; i < array->n_children; i++) {
+            bytes += array_bytes(schema->children[i], array->children[i]);
+        }
+
+        return bytes;
+    }
+
+    if (array->n_buffers > 0 && array->buffers[0] != nullptr) {
+        bytes += (n + 7) / 8;
+    }
+
+    if (strcmp(format, "z") == 0 || strcmp(format, "u") == 0) {
+        const int32_t* offsets = reinterpret_cast<const int32_t*>(array->buffers[1]);
+        bytes += (n + 1) * sizeof(int32_t) + offsets[n];
+    } else if (strcmp(format, "Z") == 0 || strcmp(format, "U") == 0) {
+        const int64_t* offsets = reinterpret_cast<const int64_t*>(array->buffers[1]);
+        bytes += (n + 1) * sizeof(int64_t) + offsets[n];
+    } else if (strcmp(format, "+l") == 0) {
+        bytes += (n + 1) * sizeof(int32_t);
+    } else if (strcmp(format, "+L") == 0) {
+        bytes += (n + 1) * sizeof(int64_t);
+    } else if (strncmp(format, "w:", 2) == 0) {
+        bytes += n * atoi(format + 2);
+    } else if (format[0] != '+' && format[1] == '\0') {
+        switch (format[0]) {
+        case 'c': case 'C': bytes += n; break;
+        case 's': case 'S': case 'e': bytes += n * 2; break;
+        case 'i': case 'I': case 'f': bytes += n * 4; break;
+        case 'l': case 'L': case 'g': bytes += n * 8; break;
+        default: break;
+        }
+    }
+
+    for (int64_t i = 0; i < array->n_children; i++) {
+        bytes += array_bytes(schema->children[i], array->children[i]);
+    }
+
+    return bytes;
+}
+
+// One column of one .feather file (e.g., "linestring_z-wkb" is the
+// "wkb" encoding of the "linestring_z" group)
+class Input {
+public:
+    Input(): n_features(0), n_vertices(0), n_bytes(0) {
+        schema.release = nullptr;
+    }
+
+    ~Input() {
+        for (struct ArrowArray& batch: batches) {
+            if (batch.release != nullptr) {
+                batch.release(&batch);
+            }
+        }
+
+        if (schema.release != nullptr) {
+            schema.release(&schema);
+        }
+    }
+
+    std::string name;
+    std::string group;
+    std::string encoding;
+    struct ArrowSchema schema;
+    std::vector<struct ArrowArray> batches;
+    int64_t n_features;
+    int64_t n_vertices;
+    int64_t n_bytes;
+};
+
+// Computes the number of features, vertices, and bytes of an input
+static void count_input(Input* input) {
+    // Throws if there is no view for this type
+    std::unique_ptr<geoarrow::ArrayView> view(geoarrow::create_view(&input->schema));
+    VertexCounter counter;
+    view->read_meta(&counter);
+    for (const struct ArrowArray& batch: input->batches) {
+        view->set_array(&batch);
+        view->read_features(&counter);
+        input->n_features += batch.length;
+        input->n_bytes += array_bytes(&input->schema, &batch);
+    }
+
+    input->n_vertices = counter.n_vertices;
+}
+
+static std::unique_ptr<Input> read_input(const std::string& path) {
+    std::unique_ptr<Input> input(new Input());
+
+    std::string basename = path.substr(path.find_last_of('/') + 1);
+    input->name = basename.substr(0, basename.find_last_of('.'));
+    size_t dash = input->name.find_last_of('-');
+    input->group = input->name.substr(0, dash);
+    input->encoding = dash == std::string::npos ? "" : input->name.substr(dash + 1);
+
+    arrow::hpp::ipc::Reader reader;
+    reader.open(path);
+    int64_t column = reader.column_index("geometry");
+    if (column == -1) {
+        column = reader.num_columns() - 1;
+    }
+
+    reader.get_schema(&input->schema, column);
+    input->batches.reserve(reader.num_batches());
+    for (int64_t i = 0; i < reader.num_batches(); i++) {
+        input->batches.push_back(ArrowArray());
+        reader.get_batch(i, &input->batches.back(), column);
+    }
+
+    count_input(input.get());
+    return input;
+}
+
+static geoarrow::ComputeBuilder* create_synthetic_builder(
+        const geoarrow::SyntheticOptions& options, const std::string& encoding) {
+    geoarrow::ComputeOptions builder_options;
+    if (encoding == "wkb") {
+        if (options.endian != -1) {
+            builder_options.set_int("endian", options.endian);
+        }
+
+        return new geoarrow::WKBArrayBuilder(builder_options);
+    }
+
+    switch (options.geometry_type) {
+    case geoarrow::util::GeometryType::POINT:
+        return new geoarrow::PointArrayBuilder(builder_options);
+    case geoarrow::util::GeometryType::LINESTRING:
+        return new geoarrow::LinestringArrayBuilder(builder_options);
+    case geoarrow::util::GeometryType::POLYGON:
+        return new geoarrow::PolygonArrayBuilder(builder_options);
+    case geoarrow::util::GeometryType::MULTIPOINT:
+        return new geoarrow::MultiPointArrayBuilder(builder_options);
+    case geoarrow::util::GeometryType::MULTILINESTRING:
+        return new geoarrow::MultiLinestringArrayBuilder(builder_options);
+    default:
+        return new geoarrow::MultiPolygonArrayBuilder(builder_options);
+    }
+}
+
+// Generates one encoding ("geoarrow" or "wkb") of a synthetic dataset,
+// writing at most options.batch_size features to each array
+static std::unique_ptr<Input> generate_input(const geoarrow::SyntheticOptions& options,
+                                             const std::string& encoding) {
+    std::unique_ptr<Input> input(new Input());
+    input->group = options.label();
+    input->encoding = encoding;
+    input->name = input->group + "-" + encoding;
+
+    geoarrow::SyntheticGenerator generator(options);
+    do {
+        std::unique_ptr<geoarrow::ComputeBuilder> builder(
+            create_synthetic_builder(options, encoding));
+        generator.read_meta(builder.get());
+        generator.read_features(builder.get(), options.batch_size);
+
+        struct ArrowSchema schema;
+        schema.release = nullptr;
+        input->batches.push_back(ArrowArray());
+        builder->release(&input->batches.back(), &schema);
+        if (input->schema.release == nullptr) {
+            memcpy(&input->schema, &schema, sizeof(struct ArrowSchema));
+        } else {
+            schema.release(&schema);
+        }
+    } while (generator.remaining() > 0);
+
+    count_input(input.get());
+    return input;
+}
+
+// Benchmarks -----------------------------------------------------------------
+
+struct Case {
+    const Input* input;
+    std::string op_label;
+    std::string op;
+    geoarrow::ComputeOptions options;
+};
+
+struct Measurement {
+    int64_t reps;
+    double seconds_per_rep;
+    int64_t allocations_per_rep;
+    int64_t output_bytes;
+};
+
+// Reads every batch of the input scale times into a single builder and
+// releases the result, returning the number of bytes in the output
+static int64_t run_case(const Case& bench_case, int64_t scale) {
+    struct ArrowSchema* schema = const_cast<struct ArrowSchema*>(&bench_case.input->schema);
+    std::unique_ptr<geoarrow::ArrayView> view(geoarrow::create_view(schema));
+    std::unique_ptr<geoarrow::ComputeBuilder> builder(
+        geoarrow::create_builder(bench_case.op, bench_case.options));
+
+    view->read_meta(builder.get());
+    for (int64_t i = 0; i < scale; i++) {
+        for (const struct ArrowArray& batch: bench_case.input->batches) {
+            view->set_array(&batch);
+            view->read_features(builder.get());
+        }
+    }
+
+    struct ArrowArray array_out;
+    struct ArrowSchema schema_out;
+    array_out.release = nullptr;
+    schema_out.release = nullptr;
+    builder->release(&array_out, &schema_out);
+    int64_t output_bytes = array_bytes(&schema_out, &array_out);
+    array_out.release(&array_out);
+    schema_out.release(&schema_out);
+    return output_bytes;
+}
+
+static Measurement measure_case(const Case& bench_case, int64_t scale, double min_time) {
+    typedef std::chrono::steady_clock clock;
+    Measurement out;
+
+    // The first run is a warmup and counts allocations, which don't depend
+    // on timing
+    int64_t allocations_start = n_allocations;
+    out.output_bytes = run_case(bench_case, scale);
+    out.allocations_per_rep = n_allocations - allocations_start;
+
+    out.reps = 0;
+    double elapsed = 0;
+    clock::time_point start = clock::now();
+    while (out.reps == 0 || elapsed < min_time) {
+        run_case(bench_case, scale);
+        out.reps++;
+        elapsed = std::chrono::duration<double>(clock::now() - start).count();
+    }
+
+    out.seconds_per_rep = elapsed / out.reps;
+    return out;
+}
+
+static void print_header(bool csv) {
+    if (csv) {
+        printf("input,scale,op,features,vertices,input_bytes,output_bytes,reps,"
+               "seconds,features_per_second,vertices_per_second,bytes_per_second,"
+               "allocations\n");
+    } else {
+        printf("%-36s %5s %-24s %10s %10s %10s %10s %10s %9s\n",
+               "input", "scale", "op", "ms", "Mfeat/s", "Mvert/s", "MB/s",
+               "out MB", "allocs");
+    }
+}
+
+static void print_measurement(const Case& bench_case, int64_t scale, const Measurement& m,
+                              bool csv) {
+    const Input& input = *bench_case.input;
+    double n_features = static_cast<double>(input.n_features) * scale;
+    double n_vertices = static_cast<double>(input.n_vertices) * scale;
+    double n_bytes = static_cast<double>(input.n_bytes) * scale;
+    double seconds = m.seconds_per_rep;
+
+    if (csv) {
+        printf("%s,%lld,%s,%.0f,%.0f,%.0f,%lld,%lld,%.9g,%.6g,%.6g,%.6g,%lld\n",
+               input.name.c_str(), (long long) scale, bench_case.op_label.c_str(),
+               n_features, n_vertices, n_bytes, (long long) m.output_bytes,
+               (long long) m.reps, seconds, n_features / seconds,
+               n_vertices / seconds, n_bytes / seconds,
+               (long long) m.allocations_per_rep);
+    } else {
+        printf("%-36s %5lld %-24s %10.3f %10.3f %10.3f %10.1f %10.3f %9lld\n",
+               input.name.c_str(), (long long) scale, bench_case.op_label.c_str(),
+               seconds * 1e3, n_features / seconds / 1e6, n_vertices / seconds / 1e6,
+               n_bytes / seconds / 1e6, m.output_bytes / 1e6,
+               (long long) m.allocations_per_rep);
+    }
+}
+
+// All operations for one input: a cast to every encoding of the same group
+// followed by the non-cast operations
+static std::vector<Case> cases_for_input(const Input& input,
+                                         const std::vector<std::unique_ptr<Input>>& inputs) {
+    std::vector<Case> cases;
+
+    for (const std::unique_ptr<Input>& target: inputs) {
+        if (target->group != input.group) {
+            continue;
+        }
+
+        Case bench_case;
+        bench_case.input = &input;
+        bench_case.op_label = "cast:" + target->encoding;
+        bench_case.op = "cast";
+        bench_case.options.set_schema(
+            "schema", const_cast<struct ArrowSchema*>(&target->schema));
+        cases.push_back(bench_case);
+    }
+
+    const char* ops[] = {"void", "global_bounds", "geoparquet_types", "feature_stats"};
+    for (const char* op: ops) {
+        Case bench_case;
+        bench_case.input = &input;
+        bench_case.op_label = op;
+        bench_case.op = op;
+        bench_case.options.set_bool("null_is_empty", true);
+        bench_case.options.set_bool("include_empty", true);
+        cases.push_back(bench_case);
+    }
+
+    return cases;
+}
+
+static std::vector<std::string> list_feather_files(const std::string& dir) {
+    std::vector<std::string> out;
+    DIR* dir_handle = opendir(dir.c_str());
+    if (dir_handle == nullptr) {
+        throw geoarrow::util::IOException("Can't open directory '%s'", dir.c_str());
+    }
+
+    struct dirent* entry;
+    while ((entry = readdir(dir_handle)) != nullptr) {
+        std::string name = entry->d_name;
+        if (name.size() > 8 && name.substr(name.size() - 8) == ".feather") {
+            out.push_back(dir + "/" + name);
+        }
+    }
+
+    closedir(dir_handle);
+    std::sort(out.begin(), out.end());
+    return out;
+}
+
+static std::vector<int64_t> parse_scales(const char* value) {
+    std::vector<int64_t> out;
+    const char* item = value;
+    while (*item != '\0') {
+        char* end;
+        long long scale = strtoll(item, &end, 10);
+        if (end == item || scale < 1) {
+            throw geoarrow::util::IOException("Invalid --scale: '%s'", value);
+        }
+
+        out.push_back(scale);
+        item = *end == ',' ? end + 1 : end;
+    }
+
+    return out;
+}
+
+static void usage() {
+    fprintf(stderr,
+        "Usage: bench [options] [file.feather ...]\n"
+        "  --dir DIR        Read all .feather files in DIR (default ../inst/example_feather)\n"
+        "  --scale N[,N]    Read each input N times into one builder (default 1,100)\n"
+        "  --min-time SEC   Minimum time to repeat each case (default 0.05)\n"
+        "  --filter TEXT    Only run cases whose input or op contains TEXT\n"
+        "  --synthetic SPEC Also generate an input (e.g., type=polygon,features=1000000)\n"
+        "  --csv            Write CSV instead of a table\n");
+}
+
+int main(int argc, char* argv[]) {
+    std::string dir = "../inst/example_feather";
+    std::vector<std::string> files;
+    std::vector<geoarrow::SyntheticOptions> synthetic;
+    std::vector<int64_t> scales = {1, 100};
+    double min_time = 0.05;
+    std::string filter;
+    bool csv = false;
+
+    try {
+        for (int i = 1; i < argc; i++) {
+            std::string arg = argv[i];
+            bool has_value = (i + 1) < argc;
+            if (arg == "--dir" && has_value) {
+                dir = argv[++i];
+            } else if (arg == "--scale" && has_value) {
+                scales = parse_scales(argv[++i]);
+            } else if (arg == "--min-time" && has_value) {
+                min_time = atof(argv[++i]);
+            } else if (arg == "--filter" && has_value) {
+                filter = argv[++i];
+            } else if (arg == "--synthetic" && has_value) {
+                synthetic.push_back(geoarrow::SyntheticOptions::parse(argv[++i]));
+            } else if (arg == "--csv") {
+                csv = true;
+            } else if (arg.size() > 0 && arg[0] != '-') {
+                files.push_back(arg);
+            } else {
+                usage();
+                return arg == "--help" ? 0 : 1;
+            }
+        }
+
+        if (files.empty() && synthetic.empty()) {
+            files = list_feather_files(dir);
+        }
+    } catch (std::exception& e) {
+        fprintf(stderr, "%s\n", e.what());
+        return 1;
+    }
+
+    std::vector<std::unique_ptr<Input>> inputs;
+    for (const std::string& file: files) {
+        try {
+            inputs.push_back(read_input(file));
+        } catch (std::exception& e) {
+            fprintf(stderr, "Skipping '%s': %s\n", file.c_str(), e.what());
+        }
+    }
+
+    for (const geoarrow::SyntheticOptions& options: synthetic) {
+        try {
+            inputs.push_back(generate_input(options, "geoarrow"));
+            inputs.push_back(generate_input(options, "wkb"));
+        } catch (std::exception& e) {
+            fprintf(stderr, "Skipping '%s': %s\n", options.label().c_str(), e.what());
+        }
+    }
+
+    print_header(csv);
+
+    for (const std::unique_ptr<Input>& input: inputs) {
+        for (const Case& bench_case: cases_for_input(*input, inputs)) {
+            if (!filter.empty() &&
+                    input->name.find(filter) == std::string::npos &&
+                    bench_case.op_label.find(filter) == std::string::npos) {
+                continue;
+            }
+
+            for (int64_t scale: scales) {
+                try {
+                    Measurement m = measure_case(bench_case, scale, min_time);
+                    print_measurement(bench_case, scale, m, csv);
+                } catch (std::exception& e) {
+                    fprintf(stderr, "Skipping %s %s: %s\n", input->name.c_str(),
+                            bench_case.op_label.c_str(), e.what());
+                }
+            }
+
+            fflush(stdout);
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,418 @@
+
+#pragma once
+
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "geoarrow.h"
+
+// geoarrow.h undefines these after including the geoarrow-cpp headers
+#define HANDLE_OR_RETURN(expr)                                 \
+    result = expr;                                             \
+    if (result != Handler::Result::CONTINUE) return result
+
+#define HANDLE_CONTINUE_OR_BREAK(expr)                         \
+    result = expr;                                             \
+    if (result == Handler::Result::ABORT_FEATURE) \
+        continue; \
+    else if (result == Handler::Result::ABORT) break
+
+namespace geoarrow {
+
+// The size and shape of a synthetic dataset. Every feature has the same
+// shape (except null and empty features): n_parts parts for multi geometry
+// types, n_rings rings per polygon, and n_vertices vertices per ring or
+// linestring (including the closing vertex of a ring).
+class SyntheticOptions {
+public:
+    SyntheticOptions():
+      geometry_type(util::GeometryType::POLYGON),
+      dimensions(util::Dimensions::XY),
+      n_features(1000),
+      n_vertices(64),
+      n_rings(1),
+      n_parts(1),
+      null_fraction(0),
+      empty_fraction(0),
+      seed(1234),
+      batch_size(100000),
+      endian(-1) {}
+
+    util::GeometryType geometry_type;
+    util::Dimensions dimensions;
+    int64_t n_features;
+    int32_t n_vertices;
+    int32_t n_rings;
+    int32_t n_parts;
+    double null_fraction;
+    double empty_fraction;
+    uint64_t seed;
+    // The maximum number of features in each output array
+    int64_t batch_size;
+    // The byte order of WKB output (0 = big, 1 = little, -1 = native)
+    int endian;
+    std::string name;
+
+    // Parses a specification like "type=polygon,features=1000000,vertices=64"
+    // (see README.md for all keys)
+    static SyntheticOptions parse(const std::string& spec) {
+        SyntheticOptions out;
+
+        size_t start = 0;
+        while (start < spec.size()) {
+            size_t end = spec.find(',', start);
+            if (end == std::string::npos) {
+                end = spec.size();
+            }
+
+            std::string item = spec.substr(start, end - start);
+            size_t eq = item.find('=');
+            if (eq == std::string::npos) {
+                throw util::IOException("Expected key=value in synthetic spec but got '%s'",
+                                        item.c_str());
+            }
+
+            out.set(item.substr(0, eq), item.substr(eq + 1));
+            start = end + 1;
+        }
+
+        out.validate();
+        return out;
+    }
+
+    // A name for the dataset that doesn't contain '-'
+    std::string label() const {
+        if (!name.empty()) {
+            return name;
+        }
+
+        std::string out = std::string("synthetic_") + geometry_type_name(geometry_type);
+        switch (dimensions) {
+        case util::Dimensions::XYZ: out += "_z"; break;
+        case util::Dimensions::XYM: out += "_m"; break;
+        case util::Dimensions::XYZM: out += "_zm"; break;
+        default: break;
+        }
+
+        return out;
+    }
+
+private:
+    void set(const std::string& key, const std::string& value) {
+        if (key == "type") {
+            geometry_type = parse_geometry_type(value);
+        } else if (key == "dims") {
+            dimensions = parse_dimensions(value);
+        } else if (key == "features") {
+            n_features = parse_int(key, value);
+        } else if (key == "vertices") {
+            n_vertices = parse_int(key, value);
+        } else if (key == "rings") {
+            n_rings = parse_int(key, value);
+        } else if (key == "parts") {
+            n_parts = parse_int(key, value);
+        } else if (key == "null") {
+            null_fraction = atof(value.c_str());
+        } else if (key == "empty") {
+            empty_fraction = atof(value.c_str());
+        } else if (key == "seed") {
+            seed = parse_int(key, value);
+        } else if (key == "batch") {
+            batch_size = parse_int(key, value);
+        } else if (key == "endian") {
+            if (value == "big") {
+                endian = 0;
+            } else if (value == "little") {
+                endian = 1;
+            } else if (value == "native") {
+                endian = -1;
+            } else {
+                throw util::IOException("Expected endian=big, little, or native");
+            }
+        } else if (key == "name") {
+            name = value;
+        } else {
+            throw util::IOException("Unknown synthetic spec key '%s'", key.c_str());
+        }
+    }
+
+    void validate() {
+        bool is_ring = geometry_type == util::GeometryType::POLYGON ||
+            geometry_type == util::GeometryType::MULTIPOLYGON;
+        if (n_features < 0 || n_rings < 1 || n_parts < 1 || batch_size < 1 ||
+                n_vertices < (is_ring ? 4 : 1)) {
+            throw util::IOException(
+                "Synthetic spec must have features >= 0, vertices >= 1 (4 for rings), "
+                "and rings, parts, and batch >= 1");
+        }
+
+        if (null_fraction < 0 || empty_fraction < 0 || (null_fraction + empty_fraction) > 1) {
+            throw util::IOException("Synthetic spec must have 0 <= null + empty <= 1");
+        }
+
+        if (name.find('-') != std::string::npos) {
+            throw util::IOException("Synthetic spec name must not contain '-'");
+        }
+    }
+
+    static int64_t parse_int(const std::string& key, const std::string& value) {
+        char* end;
+        long long out = strtoll(value.c_str(), &end, 10);
+        if (value.empty() || *end != '\0') {
+            throw util::IOException("Expected integer for synthetic spec key '%s'",
+                                    key.c_str());
+        }
+
+        return out;
+    }
+
+    static util::GeometryType parse_geometry_type(const std::string& value) {
+        for (int i = util::GeometryType::POINT; i <= util::GeometryType::MULTIPOLYGON; i++) {
+            util::GeometryType geometry_type = static_cast<util::GeometryType>(i);
+            if (value == geometry_type_name(geometry_type)) {
+                return geometry_type;
+            }
+        }
+
+        throw util::IOException("Unsupported synthetic geometry type '%s'", value.c_str());
+    }
+
+    static util::Dimensions parse_dimensions(const std::string& value) {
+        if (value == "xy") {
+            return util::Dimensions::XY;
+        } else if (value == "xyz") {
+            return util::Dimensions::XYZ;
+        } else if (value == "xym") {
+            return util::Dimensions::XYM;
+        } else if (value == "xyzm") {
+            return util::Dimensions::XYZM;
+        } else {
+            throw util::IOException("Expected dims=xy, xyz, xym, or xyzm");
+        }
+    }
+
+    static const char* geometry_type_name(util::GeometryType geometry_type) {
+        switch (geometry_type) {
+        case util::GeometryType::POINT: return "point";
+        case util::GeometryType::LINESTRING: return "linestring";
+        case util::GeometryType::POLYGON: return "polygon";
+        case util::GeometryType::MULTIPOINT: return "multipoint";
+        case util::GeometryType::MULTILINESTRING: return "multilinestring";
+        case util::GeometryType::MULTIPOLYGON: return "multipolygon";
+        default: return "";
+        }
+    }
+};
+
+// Generates the features described by a SyntheticOptions as Handler events
+// (the same events an ArrayView would generate), such that they can be
+// written directly by any builder. Output only depends on the options (i.e.,
+// the same seed always generates the same features).
+// Features are circles of jittered vertices with a random center in
+// [-180, 180] x [-90, 90]; holes and parts are smaller circles around the
+// same center. Z values are random and M values are the vertex index.
+class SyntheticGenerator {
+public:
+    SyntheticGenerator(const SyntheticOptions& options):
+      options_(options), feature_id_(0), state_(0) {
+        switch (options_.dimensions) {
+        case util::Dimensions::XYZ:
+        case util::Dimensions::XYM:
+            coord_size_ = 3;
+            break;
+        case util::Dimensions::XYZM:
+            coord_size_ = 4;
+            break;
+        default:
+            coord_size_ = 2;
+            break;
+        }
+
+        // Rings are closed, so the last vertex repeats the first
+        bool is_ring = options_.geometry_type == util::GeometryType::POLYGON ||
+            options_.geometry_type == util::GeometryType::MULTIPOLYGON;
+        int32_t n_angles = is_ring ? (options_.n_vertices - 1) : options_.n_vertices;
+        for (int32_t i = 0; i < n_angles; i++) {
+            double angle = 2 * 3.14159265358979323846 * i / n_angles;
+            cos_.push_back(cos(angle));
+            sin_.push_back(sin(angle));
+        }
+
+        coords_.resize(options_.n_vertices * coord_size_);
+    }
+
+    // The number of features that have not yet been generated
+    int64_t remaining() const { return options_.n_features - feature_id_; }
+
+    void read_meta(Handler* handler) {
+        handler->new_geometry_type(options_.geometry_type);
+        handler->new_dimensions(options_.dimensions);
+    }
+
+    // Generates the next n features (or all remaining features if n is -1)
+    Handler::Result read_features(Handler* handler, int64_t n = -1) {
+        if (n < 0 || n > remaining()) {
+            n = remaining();
+        }
+
+        Handler::Result result;
+        for (int64_t i = 0; i < n; i++) {
+            HANDLE_CONTINUE_OR_BREAK(read_feature(handler));
+        }
+
+        if (result == Handler::Result::ABORT) {
+            return Handler::Result::ABORT;
+        } else {
+            return Handler::Result::CONTINUE;
+        }
+    }
+
+    Handler::Result read_feature(Handler* handler) {
+        // Each feature has its own random state such that changing the null
+        // or empty fraction (or the batch size) doesn't change the others
+        state_ = mix(options_.seed ^ mix(feature_id_));
+        feature_id_++;
+
+        double kind = uniform();
+        double center_x = uniform() * 360 - 180;
+        double center_y = uniform() * 180 - 90;
+
+        Handler::Result result;
+        HANDLE_OR_RETURN(handler->feat_start());
+
+        if (kind < options_.null_fraction) {
+            HANDLE_OR_RETURN(handler->null_feat());
+        } else if (kind < (options_.null_fraction + options_.empty_fraction)) {
+            HANDLE_OR_RETURN(handler->geom_start(options_.geometry_type, 0));
+            HANDLE_OR_RETURN(handler->geom_end());
+        } else {
+            HANDLE_OR_RETURN(read_geometry(handler, center_x, center_y));
+        }
+
+        HANDLE_OR_RETURN(handler->feat_end());
+        return Handler::Result::CONTINUE;
+    }
+
+private:
+    SyntheticOptions options_;
+    int64_t feature_id_;
+    uint64_t state_;
+    int32_t coord_size_;
+    std::vector<double> cos_;
+    std::vector<double> sin_;
+    std::vector<double> coords_;
+
+    Handler::Result read_geometry(Handler* handler, double center_x, double center_y) {
+        Handler::Result result;
+        util::GeometryType child_type;
+
+        switch (options_.geometry_type) {
+        case util::GeometryType::MULTIPOINT:
+            child_type = util::GeometryType::POINT;
+            break;
+        case util::GeometryType::MULTILINESTRING:
+            child_type = util::GeometryType::LINESTRING;
+            break;
+        case util::GeometryType::MULTIPOLYGON:
+            child_type = util::GeometryType::POLYGON;
+            break;
+        default:
+            return read_part(handler, options_.geometry_type, center_x, center_y, 1);
+        }
+
+        HANDLE_OR_RETURN(handler->geom_start(options_.geometry_type, options_.n_parts));
+        for (int32_t i = 0; i < options_.n_parts; i++) {
+            double radius = 1.0 / (i + 1);
+            HANDLE_OR_RETURN(read_part(handler, child_type, center_x, center_y, radius));
+        }
+
+        return handler->geom_end();
+    }
+
+    Handler::Result read_part(Handler* handler, util::GeometryType geometry_type,
+                              double center_x, double center_y, double radius) {
+        Handler::Result result;
+
+        switch (geometry_type) {
+        case util::GeometryType::POINT:
+            HANDLE_OR_RETURN(handler->geom_start(geometry_type, 1));
+            fill_point(coords_.data(), center_x + radius, center_y, 0);
+            HANDLE_OR_RETURN(handler->coords(coords_.data(), 1, coord_size_));
+            return handler->geom_end();
+
+        case util::GeometryType::LINESTRING:
+            HANDLE_OR_RETURN(handler->geom_start(geometry_type, options_.n_vertices));
+            fill_circle(center_x, center_y, radius, false);
+            HANDLE_OR_RETURN(handler->coords(coords_.data(), options_.n_vertices, coord_size_));
+            return handler->geom_end();
+
+        default:
+            HANDLE_OR_RETURN(handler->geom_start(geometry_type, options_.n_rings));
+            for (int32_t i = 0; i < options_.n_rings; i++) {
+                // Shells are counterclockwise and holes are clockwise
+                fill_circle(center_x, center_y, radius / (i + 1), i > 0);
+                HANDLE_OR_RETURN(handler->ring_start(options_.n_vertices));
+                HANDLE_OR_RETURN(handler->coords(coords_.data(), options_.n_vertices, coord_size_));
+                HANDLE_OR_RETURN(handler->ring_end());
+            }
+            return handler->geom_end();
+        }
+    }
+
+    void fill_circle(double center_x, double center_y, double radius, bool clockwise) {
+        int32_t n_angles = cos_.size();
+        for (int32_t i = 0; i < n_angles; i++) {
+            int32_t angle = clockwise ? (n_angles - 1 - i) : i;
+            double jitter = radius * (0.9 + 0.2 * uniform());
+            fill_point(coords_.data() + i * coord_size_,
+                       center_x + jitter * cos_[angle], center_y + jitter * sin_[angle], i);
+        }
+
+        // Close rings
+        if (n_angles < options_.n_vertices) {
+            memcpy(coords_.data() + n_angles * coord_size_, coords_.data(),
+                   coord_size_ * sizeof(double));
+        }
+    }
+
+    void fill_point(double* coord, double x, double y, int32_t vertex_id) {
+        coord[0] = x;
+        coord[1] = y;
+
+        switch (options_.dimensions) {
+        case util::Dimensions::XYZ:
+            coord[2] = uniform() * 1000;
+            break;
+        case util::Dimensions::XYM:
+            coord[2] = vertex_id;
+            break;
+        case util::Dimensions::XYZM:
+            coord[2] = uniform() * 1000;
+            coord[3] = vertex_id;
+            break;
+        default:
+            break;
+        }
+    }
+
+    // splitmix64, which is fast, has a 64-bit state, and (unlike the
+    // distributions in <random>) gives the same values everywhere
+    double uniform() {
+        uint64_t z = mix(state_ += 0x9e3779b97f4a7c15ULL);
+        return (z >> 11) * (1.0 / 9007199254740992.0);
+    }
+
+    static uint64_t mix(uint64_t z) {
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+};
+
+}
+
+#undef HANDLE_OR_RETURN
+#undef HANDLE_CONTINUE_OR_BREAK
@@ -0,0 +1,442 @@
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+#include <Rversion.h>
+#include <R_ext/Rdynload.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include "narrow.h"
+
+#if defined(R_VERSION) && R_VERSION >= R_Version(3, 6, 0)
+#define GEOARROW_HAS_ALTREP
+#include <R_ext/Altrep.h>
+#endif
+
+// Lazy projections of a single geoarrow array into R vectors. These keep a
+// reference to the array_data external pointer (which keeps the Arrow buffers
+// alive) and compute elements on access. On R versions without ALTREP the
+// same element functions are used to materialize the whole vector up front.
+
+#define GEOARROW_MAX_LIST_LEVELS 3
+
+static inline int array_has_nulls(struct ArrowArray* array) {
+    return array->buffers[0] != NULL && array->null_count != 0;
+}
+
+static inline int array_is_valid(struct ArrowArray* array, int64_t i) {
+    if (!array_has_nulls(array)) {
+        return 1;
+    }
+
+    const uint8_t* validity = (const uint8_t*) array->buffers[0];
+    int64_t j = array->offset + i;
+    return (validity[j / 8] >> (j % 8)) & 0x01;
+}
+
+// Coordinate values: one dimension of a point array with double storage.
+// The layout is c(separated, n_dim, dim_index). Like the point array view,
+// a separated point is null if any of its children is null, in which case
+// all of its coordinates are NA.
+
+static inline int separated_point_is_valid(struct ArrowArray* array, const int* layout,
+                                           R_xlen_t i) {
+    for (int j = 0; j < layout[1]; j++) {
+        if (!array_is_valid(array->children[j], array->offset + i)) {
+            return 0;
+        }
+    }
+
+    return 1;
+}
+
+static inline int separated_children_have_nulls(struct ArrowArray* array, const int* layout) {
+    for (int j = 0; j < layout[1]; j++) {
+        if (array_has_nulls(array->children[j])) {
+            return 1;
+        }
+    }
+
+    return 0;
+}
+
+static inline double coord_elt(struct ArrowArray* array, const int* layout, R_xlen_t i) {
+    if (!array_is_valid(array, i)) {
+        return NA_REAL;
+    }
+
+    if (layout[0]) {
+        if (!separated_point_is_valid(array, layout, i)) {
+            return NA_REAL;
+        }
+
+        struct ArrowArray* child = array->children[layout[2]];
+        const double* values = (const double*) child->buffers[1];
+        return values[child->offset + array->offset + i];
+    } else {
+        struct ArrowArray* child = array->children[0];
+        const double* values = (const double*) child->buffers[1];
+        return values[child->offset + (array->offset + i) * layout[1] + layout[2]];
+    }
+}
+
+// A pointer directly into the Arrow buffer is only possible if the values
+// for this dimension are contiguous and there are no nulls to mask (including
+// those of the other dimensions)
+static inline const double* coord_direct_ptr(struct ArrowArray* array, const int* layout) {
+    if (!layout[0] || array_has_nulls(array) || separated_children_have_nulls(array, layout)) {
+        return NULL;
+    }
+
+    struct ArrowArray* child = array->children[layout[2]];
+    const double* values = (const double*) child->buffers[1];
+    return values + child->offset + array->offset;
+}
+
+// Coordinate counts: the number of coordinates in each feature of a
+// linestring, polygon, or multi* array. The layout is c(n_levels, is_large...)
+// where is_large is 1 for a level with int64 ("+L") offsets. Null features
+// have zero coordinates (like wk::wk_count()).
+
+static inline int64_t list_offset(struct ArrowArray* array, int is_large, int64_t i) {
+    if (is_large) {
+        return ((const int64_t*) array->buffers[1])[array->offset + i];
+    } else {
+        return ((const int32_t*) array->buffers[1])[array->offset + i];
+    }
+}
+
+static inline int n_coords_elt(struct ArrowArray* array, const int* layout, R_xlen_t i) {
+    if (!array_is_valid(array, i)) {
+        return 0;
+    }
+
+    int64_t start = i;
+    int64_t end = i + 1;
+    for (int level = 0; level < layout[0]; level++) {
+        int is_large = layout[level + 1];
+        int64_t child_start = list_offset(array, is_large, start);
+        end = list_offset(array, is_large, end);
+        start = child_start;
+        array = array->children[0];
+    }
+
+    return (int) (end - start);
+}
+
+static SEXP coord_materialize(struct ArrowArray* array, const int* layout) {
+    SEXP result = PROTECT(Rf_allocVector(REALSXP, array->length));
+    double* result_ptr = REAL(result);
+    const double* direct = coord_direct_ptr(array, layout);
+    if (direct != NULL) {
+        memcpy(result_ptr, direct, array->length * sizeof(double));
+    } else {
+        for (R_xlen_t i = 0; i < array->length; i++) {
+            result_ptr[i] = coord_elt(array, layout, i);
+        }
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
+static SEXP n_coords_materialize(struct ArrowArray* array, const int* layout) {
+    SEXP result = PROTECT(Rf_allocVector(INTSXP, array->length));
+    int* result_ptr = INTEGER(result);
+    for (R_xlen_t i = 0; i < array->length; i++) {
+        result_ptr[i] = n_coords_elt(array, layout, i);
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
+#ifdef GEOARROW_HAS_ALTREP
+
+// For both classes, data1 is list(array_data_xptr, layout) and data2 is
+// the materialized vector (or R_NilValue if it has not been requested)
+
+static R_altrep_class_t geoarrow_coord_class;
+static R_altrep_class_t geoarrow_n_coords_class;
+
+static inline struct ArrowArray* altrep_array(SEXP x) {
+    return (struct ArrowArray*) R_ExternalPtrAddr(VECTOR_ELT(R_altrep_data1(x), 0));
+}
+
+static inline const int* altrep_layout(SEXP x) {
+    return INTEGER(VECTOR_ELT(R_altrep_data1(x), 1));
+}
+
+static R_xlen_t geoarrow_altrep_length(SEXP x) {
+    return altrep_array(x)->length;
+}
+
+static Rboolean geoarrow_altrep_inspect(SEXP x, int pre, int deep, int pvec,
+                                        void (*inspect_subtree)(SEXP, int, int, int)) {
+    Rprintf(
+        "geoarrow projection of <ArrowArray*> (length %ld, %s)\n",
+        (long) altrep_array(x)->length,
+        R_altrep_data2(x) == R_NilValue ? "lazy" : "materialized"
+    );
+    return TRUE;
+}
+
+static SEXP geoarrow_coord_materialize_altrep(SEXP x) {
+    if (R_altrep_data2(x) == R_NilValue) {
+        R_set_altrep_data2(x, coord_materialize(altrep_array(x), altrep_layout(x)));
+    }
+
+    return R_altrep_data2(x);
+}
+
+static SEXP geoarrow_coord_serialized_state(SEXP x) {
+    return geoarrow_coord_materialize_altrep(x);
+}
+
+static SEXP geoarrow_altrep_unserialize(SEXP cls, SEXP state) {
+    return state;
+}
+
+static void* geoarrow_coord_dataptr(SEXP x, Rboolean writeable) {
+    if (!writeable && R_altrep_data2(x) == R_NilValue) {
+        const double* direct = coord_direct_ptr(altrep_array(x), altrep_layout(x));
+        if (direct != NULL) {
+            return (void*) direct;
+        }
+    }
+
+    return REAL(geoarrow_coord_materialize_altrep(x));
+}
+
+static const void* geoarrow_coord_dataptr_or_null(SEXP x) {
+    if (R_altrep_data2(x) != R_NilValue) {
+        return REAL_RO(R_altrep_data2(x));
+    }
+
+    return coord_direct_ptr(altrep_array(x), altrep_layout(x));
+}
+
+static double geoarrow_coord_elt(SEXP x, R_xlen_t i) {
+    if (R_altrep_data2(x) != R_NilValue) {
+        return REAL(R_altrep_data2(x))[i];
+    }
+
+    return coord_elt(altrep_array(x), altrep_layout(x), i);
+}
+
+static R_xlen_t geoarrow_coord_get_region(SEXP x, R_xlen_t i, R_xlen_t n, double* buf) {
+    R_xlen_t length = geoarrow_altrep_length(x);
+    R_xlen_t n_out = (length - i) < n ? (length - i) : n;
+    if (R_altrep_data2(x) != R_NilValue) {
+        memcpy(buf, REAL(R_altrep_data2(x)) + i, n_out * sizeof(double));
+        return n_out;
+    }
+
+    struct ArrowArray* array = altrep_array(x);
+    const int* layout = altrep_layout(x);
+    for (R_xlen_t j = 0; j < n_out; j++) {
+        buf[j] = coord_elt(array, layout, i + j);
+    }
+
+    return n_out;
+}
+
+static SEXP geoarrow_n_coords_materialize_altrep(SEXP x) {
+    if (R_altrep_data2(x) == R_NilValue) {
+        R_set_altrep_data2(x, n_coords_materialize(altrep_array(x), altrep_layout(x)));
+    }
+
+    return R_altrep_data2(x);
+}
+
+static SEXP geoarrow_n_coords_serialized_state(SEXP x) {
+    return geoarrow_n_coords_materialize_altrep(x);
+}
+
+static void* geoarrow_n_coords_dataptr(SEXP x, Rboolean writeable) {
+    return INTEGER(geoarrow_n_coords_materialize_altrep(x));
+}
+
+static const void* geoarrow_n_coords_dataptr_or_null(SEXP x) {
+    if (R_altrep_data2(x) != R_NilValue) {
+        return INTEGER_RO(R_altrep_data2(x));
+    }
+
+    return NULL;
+}
+
+static int geoarrow_n_coords_elt(SEXP x, R_xlen_t i) {
+    if (R_altrep_data2(x) != R_NilValue) {
+        return INTEGER(R_altrep_data2(x))[i];
+    }
+
+    return n_coords_elt(altrep_array(x), altrep_layout(x), i);
+}
+
+static R_xlen_t geoarrow_n_coords_get_region(SEXP x, R_xlen_t i, R_xlen_t n, int* buf) {
+    R_xlen_t length = geoarrow_altrep_length(x);
+    R_xlen_t n_out = (length - i) < n ? (length - i) : n;
+    if (R_altrep_data2(x) != R_NilValue) {
+        memcpy(buf, INTEGER(R_altrep_data2(x)) + i, n_out * sizeof(int));
+        return n_out;
+    }
+
+    struct ArrowArray* array = altrep_array(x);
+    const int* layout = altrep_layout(x);
+    for (R_xlen_t j = 0; j < n_out; j++) {
+        buf[j] = n_coords_elt(array, layout, i + j);
+    }
+
+    return n_out;
+}
+
+#endif
+
+void geoarrow_init_altrep(DllInfo* dll) {
+#ifdef GEOARROW_HAS_ALTREP
+    geoarrow_coord_class = R_make_altreal_class("geoarrow_coord", "geoarrow", dll);
+    R_set_altrep_Length_method(geoarrow_coord_class, &geoarrow_altrep_length);
+    R_set_altrep_Inspect_method(geoarrow_coord_class, &geoarrow_altrep_inspect);
+    R_set_altrep_Serialized_state_method(geoarrow_coord_class, &geoarrow_coord_serialized_state);
+    R_set_altrep_Unserialize_method(geoarrow_coord_class, &geoarrow_altrep_unserialize);
+    R_set_altvec_Dataptr_method(geoarrow_coord_class, &geoarrow_coord_dataptr);
+    R_set_altvec_Dataptr_or_null_method(geoarrow_coord_class, &geoarrow_coord_dataptr_or_null);
+    R_set_altreal_Elt_method(geoarrow_coord_class, &geoarrow_coord_elt);
+    R_set_altreal_Get_region_method(geoarrow_coord_class, &geoarrow_coord_get_region);
+
+    geoarrow_n_coords_class = R_make_altinteger_class("geoarrow_n_coords", "geoarrow", dll);
+    R_set_altrep_Length_method(geoarrow_n_coords_class, &geoarrow_altrep_length);
+    R_set_altrep_Inspect_method(geoarrow_n_coords_class, &geoarrow_altrep_inspect);
+    R_set_altrep_Serialized_state_method(geoarrow_n_coords_class, &geoarrow_n_coords_serialized_state);
+    R_set_altrep_Unserialize_method(geoarrow_n_coords_class, &geoarrow_altrep_unserialize);
+    R_set_altvec_Dataptr_method(geoarrow_n_coords_class, &geoarrow_n_coords_dataptr);
+    R_set_altvec_Dataptr_or_null_method(geoarrow_n_coords_class, &geoarrow_n_coords_dataptr_or_null);
+    R_set_altinteger_Elt_method(geoarrow_n_coords_class, &geoarrow_n_coords_elt);
+    R_set_altinteger_Get_region_method(geoarrow_n_coords_class, &geoarrow_n_coords_get_region);
+#endif
+}
+
+static SEXP geoarrow_projection(SEXP array_data_xptr, SEXP layout_sexp, int is_coord) {
+#ifdef GEOARROW_HAS_ALTREP
+    SEXP data1 = PROTECT(Rf_allocVector(VECSXP, 2));
+    SET_VECTOR_ELT(data1, 0, array_data_xptr);
+    SET_VECTOR_ELT(data1, 1, layout_sexp);
+    R_altrep_class_t cls = is_coord ? geoarrow_coord_class : geoarrow_n_coords_class;
+    SEXP result = R_new_altrep(cls, data1, R_NilValue);
+    UNPROTECT(1);
+    return result;
+#else
+    struct ArrowArray* array = array_data_from_xptr(array_data_xptr, "array_data");
+    if (is_coord) {
+        return coord_materialize(array, INTEGER(layout_sexp));
+    } else {
+        return n_coords_materialize(array, INTEGER(layout_sexp));
+    }
+#endif
+}
+
+// Returns a list of lazy double vectors (one per dimension, named by
+// dimension) for a point array with double storage, or NULL if the
+// array has some other layout
+SEXP geoarrow_c_altrep_coords(SEXP schema_xptr, SEXP array_data_xptr) {
+    struct ArrowSchema* schema = schema_from_xptr(schema_xptr, "schema");
+    struct ArrowArray* array = array_data_from_xptr(array_data_xptr, "array_data");
+    if (schema->dictionary != NULL) {
+        return R_NilValue;
+    }
+
+    int separated;
+    int n_dim;
+    char dims[5];
+    memset(dims, 0, sizeof(dims));
+
+    if (strncmp(schema->format, "+w:", 3) == 0) {
+        separated = 0;
+        n_dim = atoi(schema->format + 3);
+        if (schema->n_children != 1 || array->n_children != 1 ||
+                strcmp(schema->children[0]->format, "g") != 0 ||
+                schema->children[0]->name == NULL ||
+                (int) strlen(schema->children[0]->name) != n_dim ||
+                n_dim < 2 || n_dim > 4) {
+            return R_NilValue;
+        }
+
+        memcpy(dims, schema->children[0]->name, n_dim);
+    } else if (strcmp(schema->format, "+s") == 0) {
+        separated = 1;
+        n_dim = schema->n_children;
+        if (array->n_children != n_dim || n_dim < 2 || n_dim > 4) {
+            return R_NilValue;
+        }
+
+        for (int j = 0; j < n_dim; j++) {
+            if (strcmp(schema->children[j]->format, "g") != 0 ||
+                    schema->children[j]->name == NULL ||
+                    strlen(schema->children[j]->name) != 1) {
+                return R_NilValue;
+            }
+
+            dims[j] = schema->children[j]->name[0];
+        }
+    } else {
+        return R_NilValue;
+    }
+
+    SEXP result = PROTECT(Rf_allocVector(VECSXP, n_dim));
+    SEXP result_names = PROTECT(Rf_allocVector(STRSXP, n_dim));
+    for (int j = 0; j < n_dim; j++) {
+        SEXP layout_sexp = PROTECT(Rf_allocVector(INTSXP, 3));
+        INTEGER(layout_sexp)[0] = separated;
+        INTEGER(layout_sexp)[1] = n_dim;
+        INTEGER(layout_sexp)[2] = j;
+        SET_VECTOR_ELT(result, j, geoarrow_projection(array_data_xptr, layout_sexp, 1));
+        UNPROTECT(1);
+
+        char dim_name[2] = {dims[j], '\0'};
+        SET_STRING_ELT(result_names, j, Rf_mkChar(dim_name));
+    }
+
+    Rf_setAttrib(result, R_NamesSymbol, result_names);
+    UNPROTECT(2);
+    return result;
+}
+
+// Returns a lazy integer vector of coordinate counts for a nested list
+// array (e.g., linestring, polygon, multipolygon) or NULL if the array has
+// some other layout. n_levels is the number of list levels between the
+// feature and the point array.
+SEXP geoarrow_c_altrep_n_coords(SEXP schema_xptr, SEXP array_data_xptr, SEXP n_levels_sexp) {
+    struct ArrowSchema* schema = schema_from_xptr(schema_xptr, "schema");
+    struct ArrowArray* array = array_data_from_xptr(array_data_xptr, "array_data");
+    int n_levels = INTEGER(n_levels_sexp)[0];
+    if (schema->dictionary != NULL || n_levels < 1 || n_levels > GEOARROW_MAX_LIST_LEVELS) {
+        return R_NilValue;
+    }
+
+    SEXP layout_sexp = PROTECT(Rf_allocVector(INTSXP, n_levels + 1));
+    int* layout = INTEGER(layout_sexp);
+    layout[0] = n_levels;
+
+    for (int level = 0; level < n_levels; level++) {
+        if (strcmp(schema->format, "+l") == 0) {
+            layout[level + 1] = 0;
+        } else if (strcmp(schema->format, "+L") == 0) {
+            layout[level + 1] = 1;
+        } else {
+            UNPROTECT(1);
+            return R_NilValue;
+        }
+
+        if (schema->n_children != 1 || array->n_children != 1) {
+            UNPROTECT(1);
+            return R_NilValue;
+        }
+
+        schema = schema->children[0];
+        array = array->children[0];
+    }
+
+    SEXP result = PROTECT(geoarrow_projection(array_data_xptr, layout_sexp, 0));
+    UNPROTECT(2);
+    return result;
+}
@@ -42,6 +42,14 @@ static inline SEXP compute_options_from_sexp(SEXP options_sexp) {
             options->set_schema(name, schema_from_xptr(value, "options[]"));
         } else if (TYPEOF(value) == LGLSXP && Rf_length(value) == 1) {
             options->set_bool(name, LOGICAL(value)[0] != 0);
+        } else if ((TYPEOF(value) == INTSXP || TYPEOF(value) == REALSXP) &&
+                   Rf_length(value) == 1) {
+            double value_double = Rf_asReal(value);
+            if (ISNAN(value_double)) {
+                Rf_error("`options[\"%s\"]` is NA", name);
+            }
+
+            options->set_int(name, value_double);
         } else {
             Rf_error("Can't convert `options[\"%s\"]` to ComputeOptions type", name);
         }
@@ -52,3 +60,11 @@ static inline SEXP compute_options_from_sexp(SEXP options_sexp) {
 
     CPP_END
 }
+
+// Only geoarrow_compute_stream() can return more than one output array
+static inline void compute_options_check_unchunked(geoarrow::ComputeOptions* options) {
+    if (geoarrow::ChunkedBuilder::is_chunked(*options)) {
+        Rf_error(
+            "`max_chunk_rows` and `max_chunk_bytes` are only supported by geoarrow_compute_stream()");
+    }
+}
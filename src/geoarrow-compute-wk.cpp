@@ -33,15 +33,33 @@
     return WK_ABORT;
 
 
+// wk calls coord() once per coordinate; instead of passing each one to the
+// builder, coordinates are collected here and passed in blocks when their
+// ring or geometry ends (or when the block is full)
+#define BUILDER_COORD_BLOCK_SIZE 1024
+
 typedef struct {
     geoarrow::ComputeBuilder* builder;
     int coord_size;
     geoarrow::util::Dimensions dim;
     geoarrow::util::GeometryType geometry_type;
     SEXP array_sexp;
+    int64_t n_coords;
+    double coords[BUILDER_COORD_BLOCK_SIZE * 4];
     char cpp_exception_error[8096];
 } builder_handler_t;
 
+// Must be called from within WK_METHOD_CPP_START/END
+static inline geoarrow::Handler::Result builder_flush_coords(builder_handler_t* data) {
+  if (data->n_coords == 0) {
+    return geoarrow::Handler::Result::CONTINUE;
+  }
+
+  int64_t n_coords = data->n_coords;
+  data->n_coords = 0;
+  return data->builder->coords(data->coords, n_coords, data->coord_size);
+}
+
 int builder_vector_start(const wk_vector_meta_t* meta, void* handler_data) {
   builder_handler_t* data = (builder_handler_t*) handler_data;
   WK_METHOD_CPP_START
@@ -89,6 +107,9 @@ SEXP builder_vector_end(const wk_vector_meta_t* meta, void* handler_data) {
 
 int builder_feature_start(const wk_vector_meta_t* meta, R_xlen_t feat_id, void* handler_data) {
   builder_handler_t* data = (builder_handler_t*) handler_data;
+  // in case a previous feature was aborted with coordinates in the block
+  data->n_coords = 0;
+
   WK_METHOD_CPP_START
   return static_cast<int>(data->builder->feat_start());
   WK_METHOD_CPP_END_INT
@@ -153,6 +174,11 @@ int builder_geometry_start(const wk_meta_t* meta, uint32_t part_id, void* handle
 int builder_geometry_end(const wk_meta_t* meta, uint32_t part_id, void* handler_data) {
   builder_handler_t* data = (builder_handler_t*) handler_data;
   WK_METHOD_CPP_START
+  geoarrow::Handler::Result result = builder_flush_coords(data);
+  if (result != geoarrow::Handler::Result::CONTINUE) {
+    return static_cast<int>(result);
+  }
+
   return static_cast<int>(data->builder->geom_end());
   WK_METHOD_CPP_END_INT
 }
@@ -172,14 +198,26 @@ int builder_ring_start(const wk_meta_t* meta, uint32_t size, uint32_t ring_id, v
 int builder_ring_end(const wk_meta_t* meta, uint32_t size, uint32_t ring_id, void* handler_data) {
   builder_handler_t* data = (builder_handler_t*) handler_data;
   WK_METHOD_CPP_START
+  geoarrow::Handler::Result result = builder_flush_coords(data);
+  if (result != geoarrow::Handler::Result::CONTINUE) {
+    return static_cast<int>(result);
+  }
+
   return static_cast<int>(data->builder->ring_end());
   WK_METHOD_CPP_END_INT
 }
 
 int builder_coord(const wk_meta_t* meta, const double* coord, uint32_t coord_id, void* handler_data) {
   builder_handler_t* data = (builder_handler_t*) handler_data;
+  memcpy(data->coords + data->n_coords * data->coord_size, coord,
+         data->coord_size * sizeof(double));
+  data->n_coords++;
+  if (data->n_coords < BUILDER_COORD_BLOCK_SIZE) {
+    return WK_CONTINUE;
+  }
+
   WK_METHOD_CPP_START
-  return static_cast<int>(data->builder->coords(coord, 1, data->coord_size));
+  return static_cast<int>(builder_flush_coords(data));
   WK_METHOD_CPP_END_INT
 }
 
@@ -202,6 +240,7 @@ extern "C" SEXP geoarrow_c_compute_handler_new(SEXP op_sexp, SEXP array_sexp_out
 
   SEXP options_xptr = PROTECT(compute_options_from_sexp(options_sexp));
   auto options = reinterpret_cast<geoarrow::ComputeOptions*>(R_ExternalPtrAddr(options_xptr));
+  compute_options_check_unchunked(options);
 
   geoarrow::ComputeBuilder* builder = geoarrow::create_builder(op, *options);
   SEXP builder_xptr = PROTECT(R_MakeExternalPtr(builder, options_xptr, R_NilValue));
@@ -238,6 +277,7 @@ extern "C" SEXP geoarrow_c_compute_handler_new(SEXP op_sexp, SEXP array_sexp_out
   data->dim = geoarrow::util::Dimensions::DIMENSIONS_UNKNOWN;
   data->geometry_type = geoarrow::util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
   data->builder = builder;
+  data->n_coords = 0;
   data->array_sexp = array_sexp_out;
   memset(data->cpp_exception_error, 0, 8096);
 
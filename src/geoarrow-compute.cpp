@@ -8,6 +8,8 @@
 #include "util.h"
 #include "compute-util.h"
 
+#include <memory>
+
 #define HANDLE_CONTINUE_OR_BREAK(expr)                         \
     result = expr;                                             \
     if (result == geoarrow::Handler::Result::ABORT_FEATURE) \
@@ -22,10 +24,15 @@ extern "C" SEXP geoarrow_c_compute(SEXP op_sexp,
                                    SEXP options_sexp) {
     CPP_START
 
+    // Only records anything if compiled with -DGEOARROW_INSTRUMENT
+    geoarrow::instrument::PhaseTimer timer;
+
     const char* op = Rf_translateCharUTF8(STRING_ELT(op_sexp, 0));
 
     SEXP options_xptr = PROTECT(compute_options_from_sexp(options_sexp));
     auto options = reinterpret_cast<geoarrow::ComputeOptions*>(R_ExternalPtrAddr(options_xptr));
+    compute_options_check_unchunked(options);
+    timer.lap(geoarrow::instrument::PHASE_OPTIONS_NS);
 
     struct ArrowSchema* schema_from = schema_from_xptr(
         VECTOR_ELT(array_from_sexp, 0),
@@ -40,23 +47,39 @@ extern "C" SEXP geoarrow_c_compute(SEXP op_sexp,
         R_ExternalPtrAddr(VECTOR_ELT(array_to_sexp, 1)));
 
     // Get the ArrayView to read array_from
-    geoarrow::ArrayView* view = geoarrow::create_view(schema_from);
-    SEXP view_xptr = PROTECT(R_MakeExternalPtr(view, R_NilValue, R_NilValue));
-    R_RegisterCFinalizer(view_xptr, &delete_array_view_xptr);
+    geoarrow::PooledView* pooled_view = geoarrow::ViewPool::global().acquire(schema_from);
+    SEXP view_xptr = PROTECT(R_MakeExternalPtr(pooled_view, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(view_xptr, &delete_pooled_view_xptr);
+    geoarrow::ArrayView* view = pooled_view->view();
+    timer.lap(geoarrow::instrument::PHASE_CREATE_VIEW_NS);
 
     // Get the builder to build array_to
     geoarrow::ComputeBuilder* builder = geoarrow::create_builder(op, *options);
     SEXP builder_xptr = PROTECT(R_MakeExternalPtr(builder, array_to_sexp, options_xptr));
     R_RegisterCFinalizer(builder_xptr, &delete_array_builder_xptr);
+    timer.lap(geoarrow::instrument::PHASE_CREATE_BUILDER_NS);
+
+    // Handler events are counted by passing them through a CountingHandler
+    geoarrow::instrument::CountingHandler counting_handler(builder);
+    geoarrow::Handler* handler = builder;
+    if (geoarrow::instrument::enabled()) {
+        handler = &counting_handler;
+    }
 
     // Do the compute operation on a (possible) subset of the array
-    view->read_meta(builder);
+    view->read_meta(handler);
     view->set_array(array_data_from);
 
     if (TYPEOF(filter_sexp) == LGLSXP &&
         Rf_length(filter_sexp) == 1 &&
         LOGICAL(filter_sexp)[0] == 1) {
-        view->read_features(builder);
+        // The builder may read the view's buffers more directly than
+        // through handler events, but not if the events are being counted
+        if (handler == builder) {
+            builder->read_view(view);
+        } else {
+            view->read_features(handler);
+        }
     } else if (TYPEOF(filter_sexp) == LGLSXP &&
                Rf_xlength(filter_sexp) == array_data_from->length) {
         // for now, don't worry about ALTREP
@@ -65,11 +88,11 @@ extern "C" SEXP geoarrow_c_compute(SEXP op_sexp,
 
         for (int64_t i = 0; i < array_data_from->length; i++) {
             if (filter[i] == NA_LOGICAL) {
-                HANDLE_CONTINUE_OR_BREAK(builder->feat_start());
-                HANDLE_CONTINUE_OR_BREAK(builder->null_feat());
-                HANDLE_CONTINUE_OR_BREAK(builder->feat_end());
+                HANDLE_CONTINUE_OR_BREAK(handler->feat_start());
+                HANDLE_CONTINUE_OR_BREAK(handler->null_feat());
+                HANDLE_CONTINUE_OR_BREAK(handler->feat_end());
             } else if (filter[i]) {
-                HANDLE_CONTINUE_OR_BREAK(view->read_feature(builder, i));
+                HANDLE_CONTINUE_OR_BREAK(view->read_feature(handler, i));
             }
         }
     } else if (TYPEOF(filter_sexp) == INTSXP) {
@@ -82,11 +105,11 @@ extern "C" SEXP geoarrow_c_compute(SEXP op_sexp,
             if (filter[i] == NA_INTEGER ||
                 filter[i] < 1 ||
                 filter[i] > array_data_from->length) {
-                HANDLE_CONTINUE_OR_BREAK(builder->feat_start());
-                HANDLE_CONTINUE_OR_BREAK(builder->null_feat());
-                HANDLE_CONTINUE_OR_BREAK(builder->feat_end());
+                HANDLE_CONTINUE_OR_BREAK(handler->feat_start());
+                HANDLE_CONTINUE_OR_BREAK(handler->null_feat());
+                HANDLE_CONTINUE_OR_BREAK(handler->feat_end());
             } else {
-                HANDLE_CONTINUE_OR_BREAK(view->read_feature(builder, filter[i] - 1));
+                HANDLE_CONTINUE_OR_BREAK(view->read_feature(handler, filter[i] - 1));
             }
         }
     } else if (TYPEOF(filter_sexp) == REALSXP) {
@@ -99,19 +122,27 @@ extern "C" SEXP geoarrow_c_compute(SEXP op_sexp,
             if (ISNA(filter[i]) || ISNAN(filter[i]) ||
                 filter[i] < 1 ||
                 filter[i] > array_data_from->length) {
-                HANDLE_CONTINUE_OR_BREAK(builder->feat_start());
-                HANDLE_CONTINUE_OR_BREAK(builder->null_feat());
-                HANDLE_CONTINUE_OR_BREAK(builder->feat_end());
+                HANDLE_CONTINUE_OR_BREAK(handler->feat_start());
+                HANDLE_CONTINUE_OR_BREAK(handler->null_feat());
+                HANDLE_CONTINUE_OR_BREAK(handler->feat_end());
             } else {
-                HANDLE_CONTINUE_OR_BREAK(view->read_feature(builder, filter[i] - 1));
+                HANDLE_CONTINUE_OR_BREAK(view->read_feature(handler, filter[i] - 1));
             }
         }
     } else {
         Rf_error("Filter type not supported");
     }
 
+    timer.lap(geoarrow::instrument::PHASE_READ_NS);
+
+    // Return the view to the pool such that the next call with this schema
+    // doesn't have to create one
+    R_ClearExternalPtr(view_xptr);
+    geoarrow::ViewPool::global().release(pooled_view);
+
     // Transfer ownership of the built array_data and schema to array_to
-    builder->release(array_data_to, schema_to);
+    geoarrow::release_builder(builder, *options, array_data_to, schema_to);
+    timer.lap(geoarrow::instrument::PHASE_RELEASE_NS);
 
     // The pointers pointed to by array_to have been modified in place,
     // but return it anyway in case we do something else in the future
@@ -119,3 +150,177 @@ extern "C" SEXP geoarrow_c_compute(SEXP op_sexp,
     return array_to_sexp;
     CPP_END
 }
+
+extern "C" SEXP geoarrow_c_compute_stream(SEXP op_sexp,
+                                          SEXP array_stream_from_sexp,
+                                          SEXP array_stream_to_sexp,
+                                          SEXP options_sexp) {
+    CPP_START
+
+    const char* op = Rf_translateCharUTF8(STRING_ELT(op_sexp, 0));
+
+    SEXP options_xptr = PROTECT(compute_options_from_sexp(options_sexp));
+    auto options = reinterpret_cast<geoarrow::ComputeOptions*>(R_ExternalPtrAddr(options_xptr));
+
+    struct ArrowArrayStream* array_stream_from = array_stream_from_xptr(
+        array_stream_from_sexp,
+        "x");
+    struct ArrowArrayStream* array_stream_to = reinterpret_cast<struct ArrowArrayStream*>(
+        R_ExternalPtrAddr(array_stream_to_sexp));
+
+    // The ComputeStream takes ownership of array_stream_from and keeps its
+    // own copy of the options, so the output stream doesn't depend on any
+    // R object
+    std::unique_ptr<geoarrow::ComputeStream> stream(
+        new geoarrow::ComputeStream(array_stream_from, op, *options));
+    geoarrow::ComputeStream::export_stream(std::move(stream), array_stream_to);
+
+    // The input stream may reference R objects owned by its external pointer
+    R_SetExternalPtrProtected(array_stream_to_sexp, array_stream_from_sexp);
+
+    UNPROTECT(1);
+    return array_stream_to_sexp;
+    CPP_END
+}
+
+extern "C" SEXP geoarrow_c_instrument(SEXP reset_sexp) {
+    CPP_START
+
+    if (!geoarrow::instrument::enabled()) {
+        Rf_error("geoarrow was not compiled with -DGEOARROW_INSTRUMENT");
+    }
+
+    int n = geoarrow::instrument::COUNTER_COUNT;
+    const char* names[] = {"counter", "value", ""};
+    SEXP result = PROTECT(Rf_mkNamed(VECSXP, names));
+    SEXP counter_sexp = PROTECT(Rf_allocVector(STRSXP, n));
+    SEXP value_sexp = PROTECT(Rf_allocVector(REALSXP, n));
+
+    for (int i = 0; i < n; i++) {
+        auto counter = static_cast<geoarrow::instrument::Counter>(i);
+        SET_STRING_ELT(counter_sexp, i, Rf_mkChar(geoarrow::instrument::counter_names[i]));
+
+        double value = geoarrow::instrument::get(counter);
+        if (geoarrow::instrument::is_phase(counter)) {
+            value /= 1e9;
+        }
+        REAL(value_sexp)[i] = value;
+    }
+
+    if (LOGICAL(reset_sexp)[0]) {
+        geoarrow::instrument::reset();
+    }
+
+    SET_VECTOR_ELT(result, 0, counter_sexp);
+    SET_VECTOR_ELT(result, 1, value_sexp);
+    UNPROTECT(3);
+    return result;
+
+    CPP_END
+}
+
+extern "C" SEXP geoarrow_c_instrument_enabled() {
+    return Rf_ScalarLogical(geoarrow::instrument::enabled());
+}
+
+// Materializes the coordinates of each feature of a native array using the
+// pull-style feature() cursors of its view (mostly so that the cursors can be
+// tested). Points and linestrings are a matrix with one row per coordinate;
+// polygons and collections are a list of their rings or parts, and null
+// features are NULL.
+static SEXP coord_span_matrix(const geoarrow::CoordSpan& coords) {
+    R_xlen_t n = coords.size();
+    int coord_size = coords.coord_size();
+    SEXP result = PROTECT(Rf_allocMatrix(REALSXP, n, coord_size));
+    double* result_ptr = REAL(result);
+
+    const double* data = coords.data();
+    for (int j = 0; j < coord_size; j++) {
+        for (R_xlen_t i = 0; i < n; i++) {
+            if (data != nullptr) {
+                result_ptr[j * n + i] = data[i * coord_size + j];
+            } else {
+                result_ptr[j * n + i] = coords.coord(i, j);
+            }
+        }
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
+static SEXP feature_coords(const geoarrow::CoordFeature& feature) {
+    return coord_span_matrix(feature.coords());
+}
+
+static SEXP feature_coords(const geoarrow::PolygonArrayView::Feature& feature) {
+    SEXP result = PROTECT(Rf_allocVector(VECSXP, feature.num_rings()));
+    for (int64_t k = 0; k < feature.num_rings(); k++) {
+        SET_VECTOR_ELT(result, k, coord_span_matrix(feature.ring(k)));
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
+template <class Feature>
+static SEXP feature_coords(const Feature& feature) {
+    SEXP result = PROTECT(Rf_allocVector(VECSXP, feature.num_parts()));
+    for (int64_t j = 0; j < feature.num_parts(); j++) {
+        SET_VECTOR_ELT(result, j, feature_coords(feature.part(j)));
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
+template <class View>
+static SEXP view_feature_coords(View* view) {
+    int64_t n = view->array_->length;
+    SEXP result = PROTECT(Rf_allocVector(VECSXP, n));
+    for (int64_t i = 0; i < n; i++) {
+        if (!view->is_null(i)) {
+            SET_VECTOR_ELT(result, i, feature_coords(view->feature(i)));
+        }
+    }
+
+    UNPROTECT(1);
+    return result;
+}
+
+extern "C" SEXP geoarrow_c_feature_coords(SEXP schema_xptr, SEXP array_data_xptr) {
+    CPP_START
+
+    struct ArrowSchema* schema = schema_from_xptr(schema_xptr, "schema");
+    struct ArrowArray* array_data = array_data_from_xptr(array_data_xptr, "array_data");
+
+    geoarrow::ArrayView* view = geoarrow::create_view(schema);
+    SEXP view_xptr = PROTECT(R_MakeExternalPtr(view, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(view_xptr, &delete_array_view_xptr);
+    view->set_array(array_data);
+
+    SEXP result = R_NilValue;
+    if (auto point = dynamic_cast<geoarrow::PointArrayView*>(view)) {
+        result = view_feature_coords(point);
+    } else if (auto linestring = dynamic_cast<geoarrow::LinestringArrayView*>(view)) {
+        result = view_feature_coords(linestring);
+    } else if (auto polygon = dynamic_cast<geoarrow::PolygonArrayView*>(view)) {
+        result = view_feature_coords(polygon);
+    } else if (auto multipoint =
+                   dynamic_cast<geoarrow::CollectionArrayView<geoarrow::PointArrayView>*>(view)) {
+        result = view_feature_coords(multipoint);
+    } else if (auto multilinestring =
+                   dynamic_cast<geoarrow::CollectionArrayView<geoarrow::LinestringArrayView>*>(view)) {
+        result = view_feature_coords(multilinestring);
+    } else if (auto multipolygon =
+                   dynamic_cast<geoarrow::CollectionArrayView<geoarrow::PolygonArrayView>*>(view)) {
+        result = view_feature_coords(multipolygon);
+    } else {
+        throw geoarrow::Meta::ValidationError("Can't iterate over features of this array");
+    }
+
+    UNPROTECT(1);
+    return result;
+
+    CPP_END
+}
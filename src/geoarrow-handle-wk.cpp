@@ -2,6 +2,7 @@
 #include <R.h>
 #include <Rinternals.h>
 
+#include <memory>
 #include <vector>
 
 #include "wk-v1.h"
@@ -176,14 +177,36 @@ SEXP geoarrow_handle_stream(SEXP data, wk_handler_t* handler) {
     struct ArrowArrayStream* array_stream = array_stream_from_xptr(VECTOR_ELT(data, 0), "handleable");
     struct ArrowSchema* schema = schema_from_xptr(VECTOR_ELT(data, 1), "schema");
     SEXP n_features_sexp = VECTOR_ELT(data, 2);
+    int prefetch = Rf_length(data) > 3 ? INTEGER(VECTOR_ELT(data, 3))[0] : 0;
 
     // We can't stack allocate this because we don't know the exact type that is returned
     // and we can't rely on the deleter to run because one of the handler
     // calls could longjmp. We use the same trick for making sure the array_data is
     // released for each array in the stream.
-    geoarrow::ArrayView* view = geoarrow::create_view(schema);
-    SEXP view_xptr = PROTECT(R_MakeExternalPtr(view, R_NilValue, R_NilValue));
-    R_RegisterCFinalizer(view_xptr, &delete_array_view_xptr);
+    geoarrow::PooledView* pooled_view = geoarrow::ViewPool::global().acquire(schema);
+    SEXP view_xptr = PROTECT(R_MakeExternalPtr(pooled_view, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(view_xptr, &delete_pooled_view_xptr);
+    geoarrow::ArrayView* view = pooled_view->view();
+
+    // Optionally call get_next() on a background thread such that the next
+    // array(s) are produced while the handler is processing the current one.
+    // Handler calls still happen on this thread. The prefetching stream takes
+    // ownership of the input and is itself owned by an external pointer
+    // so that the thread is stopped even if a handler call longjmps.
+    struct ArrowArrayStream* prefetch_stream = (struct ArrowArrayStream*) malloc(sizeof(struct ArrowArrayStream));
+    if (prefetch_stream == NULL) {
+        Rf_error("Failed to allocate struct ArrowArrayStream");
+    }
+    prefetch_stream->release = NULL;
+    SEXP prefetch_stream_xptr = PROTECT(R_MakeExternalPtr(prefetch_stream, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(prefetch_stream_xptr, &geoarrow_finalize_array_stream);
+
+    if (prefetch > 0) {
+        std::unique_ptr<arrow::hpp::PrefetchStream> prefetcher(
+            new arrow::hpp::PrefetchStream(array_stream, prefetch));
+        arrow::hpp::PrefetchStream::export_stream(std::move(prefetcher), prefetch_stream);
+        array_stream = prefetch_stream;
+    }
 
     R_xlen_t vector_size = WK_VECTOR_SIZE_UNKNOWN;
     if (TYPEOF(n_features_sexp) == INTSXP) {
@@ -241,8 +264,17 @@ SEXP geoarrow_handle_stream(SEXP data, wk_handler_t* handler) {
         UNPROTECT(1);
     }
 
+    // Return the view to the pool (as in geoarrow_c_compute())
+    R_ClearExternalPtr(view_xptr);
+    geoarrow::ViewPool::global().release(pooled_view);
+
+    // Stops the prefetch thread (if any)
+    if (prefetch_stream->release != NULL) {
+        prefetch_stream->release(prefetch_stream);
+    }
+
     SEXP result_sexp = PROTECT(handler->vector_end(&geoarrow_handler.vector_meta_, handler->handler_data));
-    UNPROTECT(2);
+    UNPROTECT(3);
     return result_sexp;
 
     CPP_END
@@ -270,9 +302,10 @@ SEXP geoarrow_handle_vctr(SEXP data, wk_handler_t* handler) {
         array_data_offsets[j + 1] = array_data_offsets[j] + array_data_pointers[j]->length;
     }
 
-    geoarrow::ArrayView* view = geoarrow::create_view(schema);
-    SEXP view_xptr = PROTECT(R_MakeExternalPtr(view, R_NilValue, R_NilValue));
-    R_RegisterCFinalizer(view_xptr, &delete_array_view_xptr);
+    geoarrow::PooledView* pooled_view = geoarrow::ViewPool::global().acquire(schema);
+    SEXP view_xptr = PROTECT(R_MakeExternalPtr(pooled_view, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(view_xptr, &delete_pooled_view_xptr);
+    geoarrow::ArrayView* view = pooled_view->view();
 
     R_xlen_t vector_size = Rf_length(data);
     // Note: don't stack allocate this!
@@ -314,6 +347,10 @@ SEXP geoarrow_handle_vctr(SEXP data, wk_handler_t* handler) {
 
     }
 
+    // Return the view to the pool (as in geoarrow_c_compute())
+    R_ClearExternalPtr(view_xptr);
+    geoarrow::ViewPool::global().release(pooled_view);
+
     SEXP result_sexp = PROTECT(handler->vector_end(&geoarrow_handler.vector_meta_, handler->handler_data));
     UNPROTECT(4);
     return result_sexp;
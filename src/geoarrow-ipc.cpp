@@ -0,0 +1,158 @@
+
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+#include "narrow.h"
+#include "geoarrow.h"
+#include "util.h"
+#include "compute-util.h"
+
+#include <memory>
+
+extern "C" SEXP geoarrow_c_read_ipc(SEXP path_sexp, SEXP col_sexp, SEXP array_stream_xptr) {
+    CPP_START
+
+    const char* path = Rf_translateChar(STRING_ELT(path_sexp, 0));
+    struct ArrowArrayStream* array_stream = reinterpret_cast<struct ArrowArrayStream*>(
+        R_ExternalPtrAddr(array_stream_xptr));
+
+    arrow::hpp::ipc::Reader reader;
+    reader.open(path);
+
+    int64_t column = -1;
+    if (TYPEOF(col_sexp) == STRSXP) {
+        const char* col_name = Rf_translateCharUTF8(STRING_ELT(col_sexp, 0));
+        column = reader.column_index(col_name);
+        if (column == -1) {
+            throw geoarrow::util::IOException("Column '%s' not found in '%s'", col_name, path);
+        }
+    } else if (col_sexp != R_NilValue) {
+        // R indices are one-based
+        column = Rf_asInteger(col_sexp) - 1;
+    }
+
+    reader.export_stream(array_stream, column);
+    return array_stream_xptr;
+
+    CPP_END
+}
+
+// Releases a struct ArrowArray or ArrowSchema when it goes out of scope
+// (i.e., if any step of the write below throws)
+template <typename T>
+class ReleaseGuard {
+public:
+    T value;
+
+    ReleaseGuard() { value.release = nullptr; }
+
+    ~ReleaseGuard() {
+        if (value.release != nullptr) {
+            value.release(&value);
+        }
+    }
+};
+
+extern "C" SEXP geoarrow_c_write_ipc(SEXP array_stream_xptr, SEXP schema_xptr, SEXP col_sexp,
+                                     SEXP path_sexp, SEXP op_sexp, SEXP options_sexp,
+                                     SEXP file_format_sexp, SEXP name_sexp) {
+    CPP_START
+
+    struct ArrowArrayStream* array_stream = array_stream_from_xptr(array_stream_xptr, "x");
+    struct ArrowSchema* schema = schema_from_xptr(schema_xptr, "schema");
+    int col = INTEGER(col_sexp)[0];
+    const char* path = Rf_translateChar(STRING_ELT(path_sexp, 0));
+    const char* op = Rf_translateCharUTF8(STRING_ELT(op_sexp, 0));
+    bool file_format = LOGICAL(file_format_sexp)[0];
+    std::string name = Rf_translateCharUTF8(STRING_ELT(name_sexp, 0));
+
+    SEXP options_xptr = PROTECT(compute_options_from_sexp(options_sexp));
+    auto options = reinterpret_cast<geoarrow::ComputeOptions*>(R_ExternalPtrAddr(options_xptr));
+
+    // An empty op writes the input column as-is (i.e., without a copy)
+    bool cast = strcmp(op, "") != 0;
+    std::unique_ptr<geoarrow::ArrayView> view;
+    if (cast) {
+        view = std::unique_ptr<geoarrow::ArrayView>(geoarrow::create_view(schema));
+    }
+
+    arrow::hpp::ipc::Writer writer;
+    writer.open(path, file_format);
+    bool schema_written = false;
+
+    while (true) {
+        ReleaseGuard<struct ArrowArray> batch;
+        if (array_stream->get_next(array_stream, &batch.value) != 0) {
+            const char* error_message = array_stream->get_last_error(array_stream);
+            throw geoarrow::util::IOException(
+                "ArrowArrayStream->get_next() failed: %s",
+                error_message == nullptr ? "<unknown error>" : error_message);
+        }
+
+        if (batch.value.release == nullptr) {
+            break;
+        }
+
+        // Use a shallow copy of the geometry column that incorporates the
+        // offset of the parent
+        struct ArrowArray column = batch.value;
+        if (col >= 0) {
+            if (col >= batch.value.n_children) {
+                throw geoarrow::util::IOException("Column index %d is out of range", col);
+            }
+
+            column = *batch.value.children[col];
+            column.offset += batch.value.offset;
+            column.length = batch.value.length;
+        }
+
+        if (!cast) {
+            if (!schema_written) {
+                writer.write_column_schema(schema, name);
+                schema_written = true;
+            }
+
+            writer.write_batch(&column);
+            continue;
+        }
+
+        std::unique_ptr<geoarrow::ComputeBuilder> builder(
+            geoarrow::create_builder(op, *options));
+        view->read_meta(builder.get());
+        view->set_array(&column);
+        builder->read_view(view.get());
+
+        ReleaseGuard<struct ArrowArray> array_out;
+        ReleaseGuard<struct ArrowSchema> schema_out;
+        builder->release(&array_out.value, &schema_out.value);
+
+        if (!schema_written) {
+            writer.write_column_schema(&schema_out.value, name);
+            schema_written = true;
+        }
+
+        writer.write_batch(&array_out.value);
+    }
+
+    // A stream with zero batches still needs a schema message
+    if (!schema_written && !cast) {
+        writer.write_column_schema(schema, name);
+    } else if (!schema_written) {
+        std::unique_ptr<geoarrow::ComputeBuilder> builder(
+            geoarrow::create_builder(op, *options));
+        view->read_meta(builder.get());
+
+        ReleaseGuard<struct ArrowArray> array_out;
+        ReleaseGuard<struct ArrowSchema> schema_out;
+        builder->release(&array_out.value, &schema_out.value);
+        writer.write_column_schema(&schema_out.value, name);
+    }
+
+    writer.close();
+
+    UNPROTECT(1);
+    return Rf_ScalarReal(writer.num_batches());
+
+    CPP_END
+}
@@ -0,0 +1,1152 @@
+#define R_NO_REMAP
+#include <R.h>
+#include <Rinternals.h>
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <vector>
+
+#include "narrow.h"
+#include "geoarrow.h"
+#include "util.h"
+#include "compute-util.h"
+
+#define HANDLE_OR_RETURN(expr)                                 \
+    result = expr;                                             \
+    if (result != geoarrow::Handler::Result::CONTINUE) return result
+
+#define HANDLE_CONTINUE_OR_BREAK(expr)                         \
+    result = expr;                                             \
+    if (result == geoarrow::Handler::Result::ABORT_FEATURE) \
+        continue; \
+    else if (result == geoarrow::Handler::Result::ABORT) break
+
+// The sf names of each geoarrow::util::GeometryType
+static const char* const type_names[] = {
+    "GEOMETRY", "POINT", "LINESTRING", "POLYGON", "MULTIPOINT", "MULTILINESTRING",
+    "MULTIPOLYGON", "GEOMETRYCOLLECTION"
+};
+
+static const char* const sfc_class_names[] = {
+    "sfc_GEOMETRY", "sfc_POINT", "sfc_LINESTRING", "sfc_POLYGON", "sfc_MULTIPOINT",
+    "sfc_MULTILINESTRING", "sfc_MULTIPOLYGON", "sfc_GEOMETRYCOLLECTION"
+};
+
+// Builds an sfc (a list of sf geometries plus the attributes that sf expects)
+// directly from Handler events instead of passing one coordinate at a time
+// to wk's sfc_writer(). Coordinate matrices are allocated at their final size
+// when the number of coordinates is known (native and WKB arrays) such that
+// each ring or linestring is written by one transposing pass; sequences whose
+// size isn't known (WKT) are buffered and copied when they end. Every R object
+// under construction lives in stack_, which must be protected by the caller.
+class SfcBuilder: public geoarrow::Handler {
+public:
+    static const int kMaxDepth = 32;
+
+    // stack must be a list of length kMaxDepth + 1 whose first item is a
+    // list with (ideally) one item per feature
+    SfcBuilder(SEXP stack):
+      stack_(stack), geometry_type_(geoarrow::util::GeometryType::GEOMETRY_TYPE_UNKNOWN),
+      dimensions_(geoarrow::util::Dimensions::DIMENSIONS_UNKNOWN), depth_(0),
+      feat_id_(-1), feat_has_geometry_(false), feat_non_empty_(false), n_empty_(0),
+      sfc_type_(-2), has_z_(false), has_m_(false) {
+        for (int j = 0; j < 4; j++) {
+            range_min_[j] = std::numeric_limits<double>::infinity();
+            range_max_[j] = -std::numeric_limits<double>::infinity();
+        }
+    }
+
+    void new_geometry_type(geoarrow::util::GeometryType geometry_type) {
+        geometry_type_ = geometry_type;
+    }
+
+    void new_dimensions(geoarrow::util::Dimensions dimensions) {
+        dimensions_ = dimensions;
+    }
+
+    Result feat_start() {
+        feat_id_++;
+        depth_ = 0;
+        feat_has_geometry_ = false;
+        feat_non_empty_ = false;
+        return Result::CONTINUE;
+    }
+
+    Result geom_start(geoarrow::util::GeometryType geometry_type, int32_t size) {
+        Level* level = push_level();
+        level->geometry_type = geometry_type;
+        level->is_ring = false;
+        level->size = size;
+
+        // The coordinates of each point in a multipoint are written to the
+        // multipoint's matrix
+        level->forward = depth_ > 1 &&
+            geometry_type == geoarrow::util::GeometryType::POINT &&
+            levels_[depth_ - 2].geometry_type == geoarrow::util::GeometryType::MULTIPOINT;
+
+        if (!level->forward && !is_sequence(*level)) {
+            SET_VECTOR_ELT(stack_, depth_, Rf_allocVector(VECSXP, size >= 0 ? size : 4));
+        }
+
+        return Result::CONTINUE;
+    }
+
+    Result ring_start(int32_t size) {
+        Level* level = push_level();
+        level->geometry_type = geoarrow::util::GeometryType::LINESTRING;
+        level->is_ring = true;
+        level->size = size;
+        return Result::CONTINUE;
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        Level* level = coord_level(coord_size, n);
+
+        if (level->coords == nullptr) {
+            for (int64_t i = 0; i < n * coord_size; i++) {
+                level->buffer.push_back(coord[i]);
+            }
+
+            for (int32_t j = 0; j < coord_size; j++) {
+                update_range(j, coord_size, coord + j, n, coord_size);
+            }
+        } else {
+            for (int32_t j = 0; j < coord_size; j++) {
+                double* dst = level->coords + j * level->size + level->n;
+                const double* src = coord + j;
+                for (int64_t i = 0; i < n; i++) {
+                    dst[i] = src[i * coord_size];
+                }
+
+                update_range(j, coord_size, dst, n, 1);
+            }
+        }
+
+        level->n += n;
+        return Result::CONTINUE;
+    }
+
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        Level* level = coord_level(coord_size, n);
+
+        if (level->coords == nullptr) {
+            for (int64_t i = 0; i < n; i++) {
+                for (int32_t j = 0; j < coord_size; j++) {
+                    level->buffer.push_back(lanes[j][i]);
+                }
+            }
+        } else {
+            for (int32_t j = 0; j < coord_size; j++) {
+                memcpy(level->coords + j * level->size + level->n, lanes[j], n * sizeof(double));
+            }
+        }
+
+        for (int32_t j = 0; j < coord_size; j++) {
+            update_range(j, coord_size, lanes[j], n, 1);
+        }
+
+        level->n += n;
+        return Result::CONTINUE;
+    }
+
+    Result ring_end() {
+        SEXP ring = PROTECT(finish_sequence(levels_[depth_ - 1]));
+        int32_t coord_size = levels_[depth_ - 1].coord_size;
+        pop_level(ring, coord_size);
+        UNPROTECT(1);
+        return Result::CONTINUE;
+    }
+
+    Result geom_end() {
+        Level& level = levels_[depth_ - 1];
+        if (level.forward) {
+            depth_--;
+            return Result::CONTINUE;
+        }
+
+        SEXP geom;
+        if (is_sequence(level)) {
+            geom = PROTECT(finish_sequence(level));
+        } else {
+            geom = PROTECT(VECTOR_ELT(stack_, depth_));
+            if (level.n < Rf_xlength(geom)) {
+                geom = Rf_xlengthgets(geom, level.n);
+                UNPROTECT(1);
+                PROTECT(geom);
+            }
+        }
+
+        int32_t coord_size = level.coord_size == 0 ? default_coord_size() : level.coord_size;
+        set_sfg_class(geom, level.geometry_type, coord_size);
+        pop_level(geom, coord_size);
+        UNPROTECT(1);
+        return Result::CONTINUE;
+    }
+
+    Result feat_end() {
+        // Null features are filled in by finish()
+        if (!feat_has_geometry_) {
+            append_feature(R_NilValue, -1);
+        }
+
+        if (!feat_non_empty_) {
+            n_empty_++;
+        }
+
+        return Result::CONTINUE;
+    }
+
+    // Returns the (unprotected) sfc
+    SEXP finish() {
+        SEXP sfc = PROTECT(VECTOR_ELT(stack_, 0));
+        R_xlen_t n = feat_id_ + 1;
+        if (n < Rf_xlength(sfc)) {
+            sfc = Rf_xlengthgets(sfc, n);
+            UNPROTECT(1);
+            PROTECT(sfc);
+        }
+
+        // sf has no null geometries: use an empty geometry of the same type
+        // as the other features (or a GEOMETRYCOLLECTION EMPTY if there
+        // isn't one)
+        int null_type = sfc_type_;
+        if (null_type == -2 && geometry_type_ >= geoarrow::util::GeometryType::POINT &&
+                geometry_type_ <= geoarrow::util::GeometryType::GEOMETRYCOLLECTION) {
+            null_type = geometry_type_;
+        } else if (null_type < 0) {
+            null_type = geoarrow::util::GeometryType::GEOMETRYCOLLECTION;
+        }
+
+        auto null_geometry_type = static_cast<geoarrow::util::GeometryType>(null_type);
+        for (R_xlen_t i: null_features_) {
+            SEXP geom = PROTECT(empty_sfg(null_geometry_type, default_coord_size()));
+            set_sfg_class(geom, null_geometry_type, default_coord_size());
+            SET_VECTOR_ELT(sfc, i, geom);
+            UNPROTECT(1);
+            feature_types_[i] = null_type;
+        }
+
+        if (sfc_type_ == -2 && null_features_.size() > 0) {
+            sfc_type_ = null_type;
+        }
+
+        const char* sfc_class_name = "sfc_GEOMETRY";
+        if (sfc_type_ >= 0) {
+            sfc_class_name = sfc_class_names[sfc_type_];
+        }
+
+        SEXP sfc_class = PROTECT(Rf_allocVector(STRSXP, 2));
+        SET_STRING_ELT(sfc_class, 0, Rf_mkChar(sfc_class_name));
+        SET_STRING_ELT(sfc_class, 1, Rf_mkChar("sfc"));
+        Rf_setAttrib(sfc, R_ClassSymbol, sfc_class);
+        UNPROTECT(1);
+
+        // Like sf::st_sfc(), record the class of each item of a mixed sfc
+        if (sfc_type_ == -1) {
+            SEXP classes = PROTECT(Rf_allocVector(STRSXP, n));
+            for (R_xlen_t i = 0; i < n; i++) {
+                SET_STRING_ELT(classes, i, Rf_mkChar(type_names[feature_types_[i]]));
+            }
+            Rf_setAttrib(sfc, Rf_install("classes"), classes);
+            UNPROTECT(1);
+        }
+
+        Rf_setAttrib(sfc, Rf_install("precision"), Rf_ScalarReal(0));
+
+        const char* bbox_names[] = {"xmin", "ymin", "xmax", "ymax"};
+        SEXP bbox = PROTECT(range(0, 1, bbox_names, "bbox"));
+        Rf_setAttrib(sfc, Rf_install("bbox"), bbox);
+        UNPROTECT(1);
+
+        if (has_z_) {
+            const char* z_range_names[] = {"zmin", "zmax"};
+            SEXP z_range = PROTECT(range(2, -1, z_range_names, "z_range"));
+            Rf_setAttrib(sfc, Rf_install("z_range"), z_range);
+            UNPROTECT(1);
+        }
+
+        if (has_m_) {
+            const char* m_range_names[] = {"mmin", "mmax"};
+            SEXP m_range = PROTECT(range(3, -1, m_range_names, "m_range"));
+            Rf_setAttrib(sfc, Rf_install("m_range"), m_range);
+            UNPROTECT(1);
+        }
+
+        // A missing CRS (the caller sets the actual CRS)
+        const char* crs_names[] = {"input", "wkt", ""};
+        SEXP crs = PROTECT(Rf_mkNamed(VECSXP, crs_names));
+        SET_VECTOR_ELT(crs, 0, Rf_ScalarString(NA_STRING));
+        SET_VECTOR_ELT(crs, 1, Rf_ScalarString(NA_STRING));
+        Rf_setAttrib(crs, R_ClassSymbol, Rf_mkString("crs"));
+        Rf_setAttrib(sfc, Rf_install("crs"), crs);
+        UNPROTECT(1);
+
+        Rf_setAttrib(sfc, Rf_install("n_empty"), Rf_ScalarInteger(n_empty_));
+
+        UNPROTECT(1);
+        return sfc;
+    }
+
+private:
+    struct Level {
+        geoarrow::util::GeometryType geometry_type;
+        bool is_ring;
+        bool forward;
+        // The number of parts or coordinates declared by geom_start() or
+        // ring_start() (-1 if unknown) and the number written
+        int64_t size;
+        int64_t n;
+        int32_t coord_size;
+        // The column-major coordinates of this level's matrix if it could be
+        // allocated at its final size (otherwise they are in buffer)
+        double* coords;
+        std::vector<double> buffer;
+    };
+
+    SEXP stack_;
+    geoarrow::util::GeometryType geometry_type_;
+    geoarrow::util::Dimensions dimensions_;
+    Level levels_[kMaxDepth];
+    int depth_;
+
+    R_xlen_t feat_id_;
+    bool feat_has_geometry_;
+    bool feat_non_empty_;
+    int n_empty_;
+    std::vector<int> feature_types_;
+    std::vector<R_xlen_t> null_features_;
+    // The geometry type of every non-null feature, -1 if they are mixed,
+    // or -2 if there are none
+    int sfc_type_;
+
+    bool has_z_;
+    bool has_m_;
+    double range_min_[4];
+    double range_max_[4];
+
+    Level* push_level() {
+        if (depth_ >= kMaxDepth) {
+            throw geoarrow::util::IOException(
+                "Can't convert geometry with more than %d levels of nesting to sfc", kMaxDepth);
+        }
+
+        Level* level = levels_ + depth_;
+        depth_++;
+        level->forward = false;
+        level->n = 0;
+        level->coord_size = 0;
+        level->coords = nullptr;
+        level->buffer.clear();
+        SET_VECTOR_ELT(stack_, depth_, R_NilValue);
+        return level;
+    }
+
+    // Removes the current level and adds its (protected) R object to its
+    // parent or, for a top-level geometry, to the result
+    void pop_level(SEXP item, int32_t coord_size) {
+        geoarrow::util::GeometryType geometry_type = levels_[depth_ - 1].geometry_type;
+        SET_VECTOR_ELT(stack_, depth_, R_NilValue);
+        depth_--;
+
+        if (depth_ == 0) {
+            append_feature(item, geometry_type);
+            return;
+        }
+
+        Level& parent = levels_[depth_ - 1];
+        parent.coord_size = std::max(parent.coord_size, coord_size);
+
+        SEXP parts = VECTOR_ELT(stack_, depth_);
+        if (parent.n >= Rf_xlength(parts)) {
+            parts = Rf_xlengthgets(parts, std::max<R_xlen_t>(4, Rf_xlength(parts) * 2));
+            SET_VECTOR_ELT(stack_, depth_, parts);
+        }
+
+        SET_VECTOR_ELT(parts, parent.n, item);
+        parent.n++;
+    }
+
+    // type is -1 for a null feature
+    void append_feature(SEXP geom, int type) {
+        SEXP sfc = VECTOR_ELT(stack_, 0);
+        if (feat_id_ >= Rf_xlength(sfc)) {
+            sfc = Rf_xlengthgets(sfc, std::max<R_xlen_t>(1024, Rf_xlength(sfc) * 2));
+            SET_VECTOR_ELT(stack_, 0, sfc);
+        }
+
+        SET_VECTOR_ELT(sfc, feat_id_, geom);
+        feature_types_.push_back(type);
+
+        if (type == -1) {
+            null_features_.push_back(feat_id_);
+            return;
+        }
+
+        feat_has_geometry_ = true;
+        if (sfc_type_ == -2) {
+            sfc_type_ = type;
+        } else if (sfc_type_ != type) {
+            sfc_type_ = -1;
+        }
+    }
+
+    bool is_sequence(const Level& level) {
+        switch (level.geometry_type) {
+        case geoarrow::util::GeometryType::POINT:
+        case geoarrow::util::GeometryType::LINESTRING:
+        case geoarrow::util::GeometryType::MULTIPOINT:
+            return true;
+        default:
+            return level.is_ring;
+        }
+    }
+
+    // The level whose matrix receives n coordinates, allocating the matrix
+    // at its final size on the first call if the size is known
+    Level* coord_level(int32_t coord_size, int64_t n) {
+        if (depth_ == 0) {
+            throw geoarrow::util::IOException("coords() called outside of a geometry");
+        }
+
+        int level_index = depth_ - 1;
+        if (levels_[level_index].forward) {
+            level_index--;
+        }
+
+        Level* level = levels_ + level_index;
+        if (level->coord_size == 0) {
+            level->coord_size = coord_size;
+            if (level->size > 0) {
+                SEXP coords;
+                if (level->geometry_type == geoarrow::util::GeometryType::POINT && !level->is_ring) {
+                    coords = Rf_allocVector(REALSXP, coord_size);
+                    level->size = 1;
+                } else {
+                    coords = Rf_allocMatrix(REALSXP, level->size, coord_size);
+                }
+
+                SET_VECTOR_ELT(stack_, level_index + 1, coords);
+                level->coords = REAL(coords);
+            }
+        } else if (level->coord_size != coord_size) {
+            throw geoarrow::util::IOException(
+                "Can't convert geometry with mixed dimensions to sfc");
+        }
+
+        if (level->coords != nullptr && (level->n + n) > level->size) {
+            throw geoarrow::util::IOException(
+                "Expected %lld coordinates but got at least %lld",
+                static_cast<long long>(level->size), static_cast<long long>(level->n + n));
+        }
+
+        return level;
+    }
+
+    // Returns the coordinate matrix (or vector for a point) of level,
+    // copying it if it wasn't allocated at its final size
+    SEXP finish_sequence(Level& level) {
+        int level_index = &level - levels_;
+        int32_t coord_size = level.coord_size == 0 ? default_coord_size() : level.coord_size;
+        level.coord_size = coord_size;
+
+        bool is_point = level.geometry_type == geoarrow::util::GeometryType::POINT && !level.is_ring;
+        if (is_point && level.n == 0) {
+            return empty_sfg(level.geometry_type, coord_size);
+        }
+
+        if (level.coords != nullptr && level.n == level.size) {
+            return VECTOR_ELT(stack_, level_index + 1);
+        }
+
+        SEXP out;
+        if (is_point) {
+            out = PROTECT(Rf_allocVector(REALSXP, coord_size));
+        } else {
+            out = PROTECT(Rf_allocMatrix(REALSXP, level.n, coord_size));
+        }
+
+        double* dst = REAL(out);
+        for (int32_t j = 0; j < coord_size; j++) {
+            for (int64_t i = 0; i < level.n; i++) {
+                if (level.coords != nullptr) {
+                    dst[j * level.n + i] = level.coords[j * level.size + i];
+                } else {
+                    dst[j * level.n + i] = level.buffer[i * coord_size + j];
+                }
+            }
+        }
+
+        UNPROTECT(1);
+        return out;
+    }
+
+    SEXP empty_sfg(geoarrow::util::GeometryType geometry_type, int32_t coord_size) {
+        switch (geometry_type) {
+        case geoarrow::util::GeometryType::POINT: {
+            SEXP out = PROTECT(Rf_allocVector(REALSXP, coord_size));
+            for (int32_t j = 0; j < coord_size; j++) {
+                REAL(out)[j] = NA_REAL;
+            }
+            UNPROTECT(1);
+            return out;
+        }
+        case geoarrow::util::GeometryType::LINESTRING:
+        case geoarrow::util::GeometryType::MULTIPOINT:
+            return Rf_allocMatrix(REALSXP, 0, coord_size);
+        default:
+            return Rf_allocVector(VECSXP, 0);
+        }
+    }
+
+    void set_sfg_class(SEXP geom, geoarrow::util::GeometryType geometry_type, int32_t coord_size) {
+        const char* dims;
+        switch (coord_size) {
+        case 3:
+            dims = dimensions_ == geoarrow::util::Dimensions::XYM ? "XYM" : "XYZ";
+            break;
+        case 4:
+            dims = "XYZM";
+            break;
+        default:
+            dims = "XY";
+            break;
+        }
+
+        SEXP geom_class = PROTECT(Rf_allocVector(STRSXP, 3));
+        SET_STRING_ELT(geom_class, 0, Rf_mkChar(dims));
+        SET_STRING_ELT(geom_class, 1, Rf_mkChar(type_names[geometry_type]));
+        SET_STRING_ELT(geom_class, 2, Rf_mkChar("sfg"));
+        Rf_setAttrib(geom, R_ClassSymbol, geom_class);
+        UNPROTECT(1);
+    }
+
+    int32_t default_coord_size() {
+        switch (dimensions_) {
+        case geoarrow::util::Dimensions::XYZ:
+        case geoarrow::util::Dimensions::XYM:
+            return 3;
+        case geoarrow::util::Dimensions::XYZM:
+            return 4;
+        default:
+            return 2;
+        }
+    }
+
+    // Updates the range of x, y, z, or m (in that order) from dimension j
+    // of n coordinates
+    void update_range(int32_t j, int32_t coord_size, const double* values, int64_t n,
+                      int64_t stride) {
+        int range_index = j;
+        if (j == 2 && coord_size == 3 && dimensions_ == geoarrow::util::Dimensions::XYM) {
+            range_index = 3;
+        }
+
+        has_z_ = has_z_ || range_index == 2;
+        has_m_ = has_m_ || range_index == 3;
+
+        double range_min = range_min_[range_index];
+        double range_max = range_max_[range_index];
+        for (int64_t i = 0; i < n; i++) {
+            double value = values[i * stride];
+            // comparisons with NaN are false
+            if (value < range_min) range_min = value;
+            if (value > range_max) range_max = value;
+        }
+
+        range_min_[range_index] = range_min;
+        range_max_[range_index] = range_max;
+
+        // A feature whose coordinates are all NaN (e.g., a native POINT EMPTY)
+        // is empty
+        if (range_index == 0 && !feat_non_empty_) {
+            for (int64_t i = 0; i < n; i++) {
+                if (!std::isnan(values[i * stride])) {
+                    feat_non_empty_ = true;
+                    break;
+                }
+            }
+        }
+    }
+
+    // Returns c(min1, min2, max1, max2) (or c(min1, max1) if j2 is -1), with
+    // NAs if there were no values
+    SEXP range(int j1, int j2, const char** names, const char* class_name) {
+        int n_ranges = j2 < 0 ? 1 : 2;
+        SEXP out = PROTECT(Rf_allocVector(REALSXP, n_ranges * 2));
+        SEXP out_names = PROTECT(Rf_allocVector(STRSXP, n_ranges * 2));
+
+        int js[] = {j1, j2};
+        for (int k = 0; k < n_ranges; k++) {
+            bool empty = range_min_[js[k]] > range_max_[js[k]];
+            REAL(out)[k] = empty ? NA_REAL : range_min_[js[k]];
+            REAL(out)[n_ranges + k] = empty ? NA_REAL : range_max_[js[k]];
+        }
+
+        for (int k = 0; k < (n_ranges * 2); k++) {
+            SET_STRING_ELT(out_names, k, Rf_mkChar(names[k]));
+        }
+
+        Rf_setAttrib(out, R_NamesSymbol, out_names);
+        Rf_setAttrib(out, R_ClassSymbol, Rf_mkString(class_name));
+        UNPROTECT(2);
+        return out;
+    }
+};
+
+static void delete_sfc_builder_xptr(SEXP sfc_builder_xptr) {
+    SfcBuilder* builder = reinterpret_cast<SfcBuilder*>(R_ExternalPtrAddr(sfc_builder_xptr));
+    if (builder != nullptr) {
+        delete builder;
+    }
+}
+
+extern "C" SEXP geoarrow_c_as_sfc_stream(SEXP data) {
+    CPP_START
+
+    struct ArrowArrayStream* array_stream = array_stream_from_xptr(VECTOR_ELT(data, 0), "handleable");
+    struct ArrowSchema* schema = schema_from_xptr(VECTOR_ELT(data, 1), "schema");
+    SEXP n_features_sexp = VECTOR_ELT(data, 2);
+
+    R_xlen_t n_features = -1;
+    if (TYPEOF(n_features_sexp) == INTSXP) {
+        if (INTEGER(n_features_sexp)[0] != NA_INTEGER) {
+            n_features = INTEGER(n_features_sexp)[0];
+        }
+    } else {
+        double n_features_double = REAL(n_features_sexp)[0];
+        if (!ISNA(n_features_double) && !ISNAN(n_features_double)) {
+            n_features = n_features_double;
+        }
+    }
+
+    // As in geoarrow_handle_stream(), anything that must be cleaned up is
+    // owned by an external pointer in case an R API call longjmps
+    geoarrow::PooledView* pooled_view = geoarrow::ViewPool::global().acquire(schema);
+    SEXP view_xptr = PROTECT(R_MakeExternalPtr(pooled_view, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(view_xptr, &delete_pooled_view_xptr);
+    geoarrow::ArrayView* view = pooled_view->view();
+
+    SEXP stack = PROTECT(Rf_allocVector(VECSXP, SfcBuilder::kMaxDepth + 1));
+    SET_VECTOR_ELT(stack, 0, Rf_allocVector(VECSXP, n_features >= 0 ? n_features : 1024));
+    SfcBuilder* builder = new SfcBuilder(stack);
+    SEXP builder_xptr = PROTECT(R_MakeExternalPtr(builder, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(builder_xptr, &delete_sfc_builder_xptr);
+
+    struct ArrowArray* array_data = (struct ArrowArray*) malloc(sizeof(struct ArrowArray));
+    if (array_data == NULL) {
+        Rf_error("Failed to allocate struct ArrowArray");
+    }
+    array_data->release = NULL;
+    SEXP array_data_wrapper = PROTECT(R_MakeExternalPtr(array_data, R_NilValue, R_NilValue));
+    R_RegisterCFinalizer(array_data_wrapper, &geoarrow_finalize_array_data);
+
+    view->read_meta(builder);
+
+    while (true) {
+        if (array_data->release != NULL) {
+            array_data->release(array_data);
+        }
+
+        int stream_result = array_stream->get_next(array_stream, array_data);
+        if (stream_result != 0) {
+            const char* error_message = array_stream->get_last_error(array_stream);
+            if (error_message != NULL) {
+                Rf_error("[%d] %s", stream_result, error_message);
+            } else {
+                Rf_error("ArrowArrayStream->get_next() failed with code %d", stream_result);
+            }
+        }
+
+        if (array_data->release == NULL) {
+            break;
+        }
+
+        view->set_array(array_data);
+        view->read_features(builder);
+    }
+
+    // Return the view to the pool for the next call with this schema
+    R_ClearExternalPtr(view_xptr);
+    geoarrow::ViewPool::global().release(pooled_view);
+
+    SEXP sfc = PROTECT(builder->finish());
+    UNPROTECT(5);
+    return sfc;
+
+    CPP_END
+}
+
+
+// Reads an sfc or a wk::xy() vector as Handler events without going through
+// wk's handler API. The sfg coordinate matrices are column-major, so each
+// linestring or ring is passed to the handler as a single coords_separated()
+// call whose lanes are the columns of the matrix (the native builders
+// interleave these in one pass). The native point and multipoint builders
+// also get runs of wk::xy() points and multipoint matrices this way. The
+// number of features and coordinates are known before the first feature,
+// so builders can reserve them up front.
+class SfcReader {
+public:
+    typedef geoarrow::Handler Handler;
+
+    SfcReader(SEXP x): x_(x), is_xy_(Rf_inherits(x, "wk_xy")), multipoint_as_lanes_(false),
+      geometry_type_(geoarrow::util::GeometryType::GEOMETRY_TYPE_UNKNOWN),
+      dimensions_(geoarrow::util::Dimensions::DIMENSIONS_UNKNOWN) {
+        if (is_xy_) {
+            xy_dimensions_ = dimensions_from(has_name(x_, "z"), has_name(x_, "m"));
+            for (R_xlen_t j = 0; j < Rf_xlength(x_); j++) {
+                check_real(VECTOR_ELT(x_, j), Rf_xlength(x_));
+            }
+        }
+    }
+
+    static bool can_read(SEXP x) {
+        return Rf_inherits(x, "sfc") || Rf_inherits(x, "wk_xy");
+    }
+
+    R_xlen_t size() {
+        if (is_xy_) {
+            return Rf_xlength(VECTOR_ELT(x_, 0));
+        } else {
+            return Rf_xlength(x_);
+        }
+    }
+
+    geoarrow::util::GeometryType vector_geometry_type() {
+        if (is_xy_) {
+            return geoarrow::util::GeometryType::POINT;
+        }
+
+        SEXP cls = Rf_getAttrib(x_, R_ClassSymbol);
+        if (Rf_length(cls) == 0) {
+            return geoarrow::util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
+        }
+
+        const char* sfc_class = CHAR(STRING_ELT(cls, 0));
+        if (strncmp(sfc_class, "sfc_", 4) != 0) {
+            return geoarrow::util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
+        }
+
+        return parse_geometry_type(sfc_class + 4, false);
+    }
+
+    geoarrow::util::Dimensions vector_dimensions() {
+        if (is_xy_) {
+            return xy_dimensions_;
+        }
+
+        return dimensions_from(
+            Rf_getAttrib(x_, Rf_install("z_range")) != R_NilValue,
+            Rf_getAttrib(x_, Rf_install("m_range")) != R_NilValue);
+    }
+
+    // The total number of coordinates in all features (which requires
+    // walking the geometry lists but not the coordinates)
+    int64_t count_coords() {
+        if (is_xy_) {
+            return size();
+        }
+
+        int64_t n = 0;
+        for (R_xlen_t i = 0; i < Rf_xlength(x_); i++) {
+            n += count_coords(VECTOR_ELT(x_, i));
+        }
+
+        return n;
+    }
+
+    Handler::Result read_features(Handler* handler) {
+        Handler::Result result = Handler::Result::CONTINUE;
+        R_xlen_t n = size();
+
+        // The native point and multipoint builders write a block of n
+        // coordinates as n points, so these can skip the per-point events
+        if (is_xy_) {
+            auto point_builder = dynamic_cast<geoarrow::PointArrayBuilder*>(handler);
+            if (point_builder != nullptr) {
+                return read_xy_runs(point_builder);
+            }
+        }
+
+        multipoint_as_lanes_ =
+            dynamic_cast<geoarrow::MultiPointArrayBuilder*>(handler) != nullptr;
+
+        for (R_xlen_t i = 0; i < n; i++) {
+            HANDLE_CONTINUE_OR_BREAK(read_feature(handler, i));
+        }
+
+        if (result == Handler::Result::ABORT) {
+            return Handler::Result::ABORT;
+        } else {
+            return Handler::Result::CONTINUE;
+        }
+    }
+
+private:
+    SEXP x_;
+    bool is_xy_;
+    bool multipoint_as_lanes_;
+    geoarrow::util::GeometryType geometry_type_;
+    geoarrow::util::Dimensions dimensions_;
+    geoarrow::util::Dimensions xy_dimensions_;
+
+    Handler::Result read_feature(Handler* handler, R_xlen_t i) {
+        Handler::Result result;
+        HANDLE_OR_RETURN(handler->feat_start());
+
+        if (is_xy_) {
+            HANDLE_OR_RETURN(read_xy(handler, i));
+        } else {
+            SEXP item = VECTOR_ELT(x_, i);
+            if (item == R_NilValue) {
+                HANDLE_OR_RETURN(handler->null_feat());
+            } else {
+                HANDLE_OR_RETURN(read_sfg(handler, item));
+            }
+        }
+
+        HANDLE_OR_RETURN(handler->feat_end());
+        return Handler::Result::CONTINUE;
+    }
+
+    Handler::Result read_xy(Handler* handler, R_xlen_t i) {
+        Handler::Result result;
+        int32_t coord_size = Rf_length(x_);
+        double coord[4];
+        bool empty = true;
+        for (int32_t j = 0; j < coord_size; j++) {
+            coord[j] = REAL(VECTOR_ELT(x_, j))[i];
+            empty = empty && std::isnan(coord[j]);
+        }
+
+        HANDLE_OR_RETURN(geom_start(handler, geoarrow::util::GeometryType::POINT,
+                                    xy_dimensions_, !empty));
+        if (!empty) {
+            HANDLE_OR_RETURN(handler->coords(coord, 1, coord_size));
+        }
+
+        return handler->geom_end();
+    }
+
+    // Like PointArrayBuilder::read_view(): each run of non-empty points is
+    // passed straight from the coordinate columns as one coords_separated()
+    // call. Empty points (all coordinates NaN) are still read as features
+    // so that the builder can write (or reject) them as POINT EMPTY.
+    Handler::Result read_xy_runs(geoarrow::PointArrayBuilder* builder) {
+        Handler::Result result = Handler::Result::CONTINUE;
+        R_xlen_t n = size();
+        int32_t coord_size = Rf_length(x_);
+        const double* columns[4];
+        for (int32_t j = 0; j < coord_size; j++) {
+            columns[j] = REAL(VECTOR_ELT(x_, j));
+        }
+
+        const double* lanes[4];
+        R_xlen_t i = 0;
+        while (i < n) {
+            if (xy_is_empty(columns, coord_size, i)) {
+                result = read_feature(builder, i);
+                if (result == Handler::Result::ABORT) {
+                    return result;
+                }
+
+                i++;
+                continue;
+            }
+
+            R_xlen_t end = i + 1;
+            while (end < n && !xy_is_empty(columns, coord_size, end)) {
+                end++;
+            }
+
+            for (int32_t j = 0; j < coord_size; j++) {
+                lanes[j] = columns[j] + i;
+            }
+
+            HANDLE_OR_RETURN(builder->coords_separated(lanes, end - i, coord_size));
+            i = end;
+        }
+
+        return Handler::Result::CONTINUE;
+    }
+
+    static bool xy_is_empty(const double* const* columns, int32_t coord_size, R_xlen_t i) {
+        for (int32_t j = 0; j < coord_size; j++) {
+            if (!std::isnan(columns[j][i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    Handler::Result read_sfg(Handler* handler, SEXP item) {
+        Handler::Result result;
+
+        SEXP cls = Rf_getAttrib(item, R_ClassSymbol);
+        if (Rf_length(cls) != 3) {
+            throw geoarrow::util::IOException("Expected sfg with class of length 3");
+        }
+
+        geoarrow::util::Dimensions dimensions = parse_dimensions(CHAR(STRING_ELT(cls, 0)));
+        geoarrow::util::GeometryType geometry_type =
+            parse_geometry_type(CHAR(STRING_ELT(cls, 1)), true);
+
+        switch (geometry_type) {
+        case geoarrow::util::GeometryType::POINT: {
+            R_xlen_t coord_size = check_real(item, Rf_xlength(item));
+            bool empty = true;
+            for (R_xlen_t j = 0; j < coord_size; j++) {
+                empty = empty && std::isnan(REAL(item)[j]);
+            }
+
+            HANDLE_OR_RETURN(geom_start(handler, geometry_type, dimensions, !empty));
+            if (!empty) {
+                HANDLE_OR_RETURN(handler->coords(REAL(item), 1, coord_size));
+            }
+            break;
+        }
+
+        case geoarrow::util::GeometryType::LINESTRING:
+            HANDLE_OR_RETURN(geom_start(handler, geometry_type, dimensions, nrow(item)));
+            HANDLE_OR_RETURN(read_matrix(handler, item));
+            break;
+
+        case geoarrow::util::GeometryType::MULTIPOINT: {
+            int64_t n = nrow(item);
+            int32_t coord_size = check_real(item, ncol(item));
+            const double* values = REAL(item);
+            double coord[4];
+
+            HANDLE_OR_RETURN(geom_start(handler, geometry_type, dimensions, n));
+            if (multipoint_as_lanes_) {
+                HANDLE_OR_RETURN(read_matrix(handler, item));
+                break;
+            }
+
+            for (int64_t i = 0; i < n; i++) {
+                for (int32_t j = 0; j < coord_size; j++) {
+                    coord[j] = values[j * n + i];
+                }
+
+                HANDLE_OR_RETURN(geom_start(handler, geoarrow::util::GeometryType::POINT,
+                                            dimensions, 1));
+                HANDLE_OR_RETURN(handler->coords(coord, 1, coord_size));
+                HANDLE_OR_RETURN(handler->geom_end());
+            }
+            break;
+        }
+
+        case geoarrow::util::GeometryType::POLYGON:
+            HANDLE_OR_RETURN(geom_start(handler, geometry_type, dimensions, Rf_xlength(item)));
+            for (R_xlen_t i = 0; i < Rf_xlength(item); i++) {
+                SEXP ring = VECTOR_ELT(item, i);
+                HANDLE_OR_RETURN(handler->ring_start(nrow(ring)));
+                HANDLE_OR_RETURN(read_matrix(handler, ring));
+                HANDLE_OR_RETURN(handler->ring_end());
+            }
+            break;
+
+        default:
+            // MULTILINESTRING, MULTIPOLYGON, and GEOMETRYCOLLECTION are lists
+            // of sfgs (with the child classes implied for the multi types)
+            HANDLE_OR_RETURN(geom_start(handler, geometry_type, dimensions, Rf_xlength(item)));
+            for (R_xlen_t i = 0; i < Rf_xlength(item); i++) {
+                HANDLE_OR_RETURN(read_part(handler, VECTOR_ELT(item, i), geometry_type, dimensions));
+            }
+            break;
+        }
+
+        return handler->geom_end();
+    }
+
+    Handler::Result read_part(Handler* handler, SEXP part,
+                              geoarrow::util::GeometryType parent_type,
+                              geoarrow::util::Dimensions dimensions) {
+        Handler::Result result;
+
+        switch (parent_type) {
+        case geoarrow::util::GeometryType::MULTILINESTRING:
+            HANDLE_OR_RETURN(geom_start(handler, geoarrow::util::GeometryType::LINESTRING,
+                                        dimensions, nrow(part)));
+            HANDLE_OR_RETURN(read_matrix(handler, part));
+            return handler->geom_end();
+
+        case geoarrow::util::GeometryType::MULTIPOLYGON:
+            HANDLE_OR_RETURN(geom_start(handler, geoarrow::util::GeometryType::POLYGON,
+                                        dimensions, Rf_xlength(part)));
+            for (R_xlen_t i = 0; i < Rf_xlength(part); i++) {
+                SEXP ring = VECTOR_ELT(part, i);
+                HANDLE_OR_RETURN(handler->ring_start(nrow(ring)));
+                HANDLE_OR_RETURN(read_matrix(handler, ring));
+                HANDLE_OR_RETURN(handler->ring_end());
+            }
+            return handler->geom_end();
+
+        default:
+            return read_sfg(handler, part);
+        }
+    }
+
+    // Like the wk handler that builds arrays from any handleable, this calls
+    // new_geometry_type() and new_dimensions() whenever they change
+    Handler::Result geom_start(Handler* handler, geoarrow::util::GeometryType geometry_type,
+                               geoarrow::util::Dimensions dimensions, int64_t size) {
+        if (geometry_type != geometry_type_) {
+            handler->new_geometry_type(geometry_type);
+            geometry_type_ = geometry_type;
+        }
+
+        if (dimensions != dimensions_) {
+            handler->new_dimensions(dimensions);
+            dimensions_ = dimensions;
+        }
+
+        return handler->geom_start(geometry_type, size);
+    }
+
+    // Passes the columns of a coordinate matrix to the handler as lanes
+    Handler::Result read_matrix(Handler* handler, SEXP matrix) {
+        int64_t n = nrow(matrix);
+        int32_t coord_size = check_real(matrix, ncol(matrix));
+        if (n == 0) {
+            return Handler::Result::CONTINUE;
+        }
+
+        const double* lanes[4];
+        for (int32_t j = 0; j < coord_size; j++) {
+            lanes[j] = REAL(matrix) + j * n;
+        }
+
+        return handler->coords_separated(lanes, n, coord_size);
+    }
+
+    int64_t count_coords(SEXP item) {
+        if (item == R_NilValue) {
+            return 0;
+        } else if (TYPEOF(item) == VECSXP) {
+            int64_t n = 0;
+            for (R_xlen_t i = 0; i < Rf_xlength(item); i++) {
+                n += count_coords(VECTOR_ELT(item, i));
+            }
+            return n;
+        } else if (Rf_isMatrix(item)) {
+            return nrow(item);
+        } else {
+            return 1;
+        }
+    }
+
+    static int64_t nrow(SEXP matrix) {
+        SEXP dim = Rf_getAttrib(matrix, R_DimSymbol);
+        if (Rf_length(dim) != 2) {
+            throw geoarrow::util::IOException("Expected sfg coordinates to be a matrix");
+        }
+
+        return INTEGER(dim)[0];
+    }
+
+    static int32_t ncol(SEXP matrix) {
+        return INTEGER(Rf_getAttrib(matrix, R_DimSymbol))[1];
+    }
+
+    static int32_t check_real(SEXP coords, R_xlen_t coord_size) {
+        if (TYPEOF(coords) != REALSXP) {
+            throw geoarrow::util::IOException("Expected sfg coordinates to be double");
+        }
+
+        if (coord_size < 2 || coord_size > 4) {
+            throw geoarrow::util::IOException(
+                "Expected sfg with 2, 3, or 4 dimensions but got %d", static_cast<int>(coord_size));
+        }
+
+        return coord_size;
+    }
+
+    static bool has_name(SEXP x, const char* name) {
+        SEXP names = Rf_getAttrib(x, R_NamesSymbol);
+        for (R_xlen_t i = 0; i < Rf_xlength(names); i++) {
+            if (strcmp(CHAR(STRING_ELT(names, i)), name) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    static geoarrow::util::Dimensions dimensions_from(bool has_z, bool has_m) {
+        if (has_z && has_m) {
+            return geoarrow::util::Dimensions::XYZM;
+        } else if (has_z) {
+            return geoarrow::util::Dimensions::XYZ;
+        } else if (has_m) {
+            return geoarrow::util::Dimensions::XYM;
+        } else {
+            return geoarrow::util::Dimensions::XY;
+        }
+    }
+
+    static geoarrow::util::Dimensions parse_dimensions(const char* dims) {
+        return dimensions_from(strchr(dims, 'Z') != nullptr, strchr(dims, 'M') != nullptr);
+    }
+
+    static geoarrow::util::GeometryType parse_geometry_type(const char* name, bool strict) {
+        for (int i = 1; i <= 7; i++) {
+            if (strcmp(name, type_names[i]) == 0) {
+                return static_cast<geoarrow::util::GeometryType>(i);
+            }
+        }
+
+        if (strict) {
+            throw geoarrow::util::IOException("Can't convert sfg of type '%s'", name);
+        }
+
+        return geoarrow::util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
+    }
+};
+
+extern "C" SEXP geoarrow_c_compute_sfc(SEXP op_sexp, SEXP x_sexp, SEXP array_to_sexp,
+                                       SEXP options_sexp) {
+    CPP_START
+
+    if (!SfcReader::can_read(x_sexp)) {
+        Rf_error("`x` must be an sfc or wk::xy() vector");
+    }
+
+    const char* op = Rf_translateCharUTF8(STRING_ELT(op_sexp, 0));
+
+    SEXP options_xptr = PROTECT(compute_options_from_sexp(options_sexp));
+    auto options = reinterpret_cast<geoarrow::ComputeOptions*>(R_ExternalPtrAddr(options_xptr));
+    compute_options_check_unchunked(options);
+
+    struct ArrowSchema* schema_to = reinterpret_cast<struct ArrowSchema*>(
+        R_ExternalPtrAddr(VECTOR_ELT(array_to_sexp, 0)));
+    struct ArrowArray* array_data_to = reinterpret_cast<struct ArrowArray*>(
+        R_ExternalPtrAddr(VECTOR_ELT(array_to_sexp, 1)));
+
+    geoarrow::ComputeBuilder* builder = geoarrow::create_builder(op, *options);
+    SEXP builder_xptr = PROTECT(R_MakeExternalPtr(builder, array_to_sexp, options_xptr));
+    R_RegisterCFinalizer(builder_xptr, &delete_array_builder_xptr);
+
+    SfcReader reader(x_sexp);
+
+    builder->new_schema(nullptr);
+    builder->new_geometry_type(reader.vector_geometry_type());
+    builder->new_dimensions(reader.vector_dimensions());
+
+    if (builder->array_start(nullptr) != geoarrow::Handler::Result::ABORT_ARRAY) {
+        builder->reserve(reader.size());
+        builder->reserve_coords(reader.count_coords());
+        reader.read_features(builder);
+    }
+
+    builder->array_end();
+    geoarrow::release_builder(builder, *options, array_data_to, schema_to);
+
+    UNPROTECT(2);
+    return array_to_sexp;
+
+    CPP_END
+}
@@ -1,11 +1,17 @@
 
 #pragma once
 
+#include "internal/geoarrow-cpp/instrument.hpp"
 #include "internal/geoarrow-cpp/handler.hpp"
 #include "internal/geoarrow-cpp/array-view-base.hpp"
 #include "internal/geoarrow-cpp/compute-builder.hpp"
 #include "internal/geoarrow-cpp/factory.hpp"
+#include "internal/geoarrow-cpp/view-pool.hpp"
 #include "internal/geoarrow-cpp/compute-factory.hpp"
+#include "internal/geoarrow-cpp/compute-stream.hpp"
+#include "internal/geoarrow-cpp/internal/arrow-hpp/stream-prefetch.hpp"
+#include "internal/geoarrow-cpp/internal/arrow-hpp/ipc-reader.hpp"
+#include "internal/geoarrow-cpp/internal/arrow-hpp/ipc-writer.hpp"
 
 #undef HANDLE_OR_RETURN
 #undef HANDLE_CONTINUE_OR_BREAK
@@ -3,25 +3,51 @@
 #include <Rinternals.h>
 #include <R_ext/Rdynload.h>
 
+SEXP geoarrow_c_altrep_coords(SEXP schema_xptr, SEXP array_data_xptr);
+SEXP geoarrow_c_altrep_n_coords(SEXP schema_xptr, SEXP array_data_xptr, SEXP n_levels_sexp);
 SEXP geoarrow_c_handle_stream(SEXP data, SEXP handler_xptr);
 SEXP geoarrow_c_handle_vctr(SEXP data, SEXP handler_xptr);
+SEXP geoarrow_c_as_sfc_stream(SEXP data);
 SEXP geoarrow_c_compute_handler_new(SEXP op_sexp, SEXP array_sexp_out, SEXP options_sexp);
 SEXP geoarrow_c_compute(SEXP op_sexp, SEXP array_from_sexp, SEXP array_to_sexp,
                         SEXP filter_sexp, SEXP options_sexp);
+SEXP geoarrow_c_compute_sfc(SEXP op_sexp, SEXP x_sexp, SEXP array_sexp_out, SEXP options_sexp);
+SEXP geoarrow_c_compute_stream(SEXP op_sexp, SEXP array_stream_from_sexp,
+                               SEXP array_stream_to_sexp, SEXP options_sexp);
+SEXP geoarrow_c_feature_coords(SEXP schema_xptr, SEXP array_data_xptr);
+SEXP geoarrow_c_instrument(SEXP reset_sexp);
+SEXP geoarrow_c_instrument_enabled(void);
 SEXP geoarrow_c_is_slice(SEXP values_sexp);
 SEXP geoarrow_c_is_identity_slice(SEXP values_sexp, SEXP total_len);
+SEXP geoarrow_c_read_ipc(SEXP path_sexp, SEXP col_sexp, SEXP array_stream_xptr);
+SEXP geoarrow_c_write_ipc(SEXP array_stream_xptr, SEXP schema_xptr, SEXP col_sexp,
+                          SEXP path_sexp, SEXP op_sexp, SEXP options_sexp,
+                          SEXP file_format_sexp, SEXP name_sexp);
+
+void geoarrow_init_altrep(DllInfo* dll);
 
 static const R_CallMethodDef CallEntries[] = {
+    {"geoarrow_c_altrep_coords", (DL_FUNC) &geoarrow_c_altrep_coords, 2},
+    {"geoarrow_c_altrep_n_coords", (DL_FUNC) &geoarrow_c_altrep_n_coords, 3},
     {"geoarrow_c_handle_stream", (DL_FUNC) &geoarrow_c_handle_stream, 2},
     {"geoarrow_c_handle_vctr", (DL_FUNC) &geoarrow_c_handle_vctr, 2},
+    {"geoarrow_c_as_sfc_stream", (DL_FUNC) &geoarrow_c_as_sfc_stream, 1},
     {"geoarrow_c_compute_handler_new", (DL_FUNC) &geoarrow_c_compute_handler_new, 3},
     {"geoarrow_c_compute", (DL_FUNC) &geoarrow_c_compute, 5},
+    {"geoarrow_c_compute_sfc", (DL_FUNC) &geoarrow_c_compute_sfc, 4},
+    {"geoarrow_c_compute_stream", (DL_FUNC) &geoarrow_c_compute_stream, 4},
+    {"geoarrow_c_feature_coords", (DL_FUNC) &geoarrow_c_feature_coords, 2},
+    {"geoarrow_c_instrument", (DL_FUNC) &geoarrow_c_instrument, 1},
+    {"geoarrow_c_instrument_enabled", (DL_FUNC) &geoarrow_c_instrument_enabled, 0},
     {"geoarrow_c_is_slice", (DL_FUNC) &geoarrow_c_is_slice, 1},
     {"geoarrow_c_is_identity_slice", (DL_FUNC) &geoarrow_c_is_identity_slice, 2},
+    {"geoarrow_c_read_ipc", (DL_FUNC) &geoarrow_c_read_ipc, 3},
+    {"geoarrow_c_write_ipc", (DL_FUNC) &geoarrow_c_write_ipc, 8},
     {NULL, NULL, 0}
 };
 
 void R_init_geoarrow(DllInfo *dll) {
     R_registerRoutines(dll, NULL, CallEntries, NULL, NULL);
     R_useDynamicSymbols(dll, FALSE);
+    geoarrow_init_altrep(dll);
 }
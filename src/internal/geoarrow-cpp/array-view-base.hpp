@@ -10,9 +10,12 @@ namespace geoarrow {
 // it is an abstract class that represents a view of a `struct ArrowSchema` and
 // a sequence of `struct ArrowArray`s, both of which must be valid pointers for the
 // lifetime of the `ArrayView`. The `ArrayView` supports handler-style
-// iteration using a `Handler` and pull-style iteration using virtual methods.
-// The handler-style iteration is particularly useful as a way to write general-purpose
-// code without using virtual methods.
+// iteration using a `Handler`, which is particularly useful as a way to write
+// general-purpose code without using virtual methods. Views of native
+// (non-serialized) types also support pull-style iteration without any
+// handler events via `feature(i)` (e.g., `feature(i).part(j).ring(k)`
+// for a multipolygon), which returns lightweight cursors whose coordinates
+// are read directly from the array's buffers.
 class ArrayView {
   public:
     ArrayView(const struct ArrowSchema* schema):
@@ -45,6 +48,7 @@ class ArrayView {
     }
 
     bool is_null(int64_t offset) {
+        offset += array_->offset;
         return validity_buffer_ &&
             (validity_buffer_[offset / 8] & (0x01 << (offset % 8))) == 0;
     }
@@ -0,0 +1,108 @@
+
+#pragma once
+
+#include <cstring>
+#include <memory>
+
+#include "meta.hpp"
+#include "handler.hpp"
+#include "array-view-base.hpp"
+
+namespace geoarrow {
+
+// A view of a dictionary-encoded array whose dictionary is any array that
+// has an ArrayView. Features are read by looking up each index in the
+// dictionary such that dictionary-encoded arrays can be read anywhere
+// the dictionary could be. The schema, geometry type, and dimensions
+// reported by read_meta() are those of the dictionary.
+class DictionaryArrayView: public ArrayView {
+  public:
+    // values must be a view of schema->dictionary
+    DictionaryArrayView(const struct ArrowSchema* schema, std::unique_ptr<ArrayView> values):
+      ArrayView(schema->dictionary), index_schema_(schema), values_(std::move(values)),
+      indices_(nullptr) {
+        index_width_ = parse_index_width(schema->format);
+    }
+
+    void set_array(const struct ArrowArray* array) {
+        if (array->n_buffers != 2) {
+            throw Meta::ValidationError("Expected dictionary indices with 2 buffers");
+        }
+
+        if (array->dictionary == nullptr) {
+            throw Meta::ValidationError("Expected dictionary-encoded array");
+        }
+
+        values_->set_array(array->dictionary);
+        array_ = array;
+        validity_buffer_ = reinterpret_cast<const uint8_t*>(array->buffers[0]);
+        indices_ = reinterpret_cast<const uint8_t*>(array->buffers[1]);
+    }
+
+    Handler::Result read_features(Handler* handler) {
+        return internal::read_features_templ<DictionaryArrayView>(*this, handler);
+    }
+
+    Handler::Result read_feature(Handler* handler, int64_t offset) {
+        if (!is_null(offset)) {
+            return values_->read_feature(handler, index(offset));
+        }
+
+        Handler::Result result;
+        HANDLE_OR_RETURN(handler->feat_start());
+        HANDLE_OR_RETURN(handler->null_feat());
+        HANDLE_OR_RETURN(handler->feat_end());
+        return Handler::Result::CONTINUE;
+    }
+
+    int64_t index(int64_t offset) {
+        offset += array_->offset;
+
+        int64_t value;
+        switch (index_width_) {
+        case 1:
+            value = reinterpret_cast<const int8_t*>(indices_)[offset];
+            break;
+        case 2:
+            value = reinterpret_cast<const int16_t*>(indices_)[offset];
+            break;
+        case 4:
+            value = reinterpret_cast<const int32_t*>(indices_)[offset];
+            break;
+        default:
+            value = reinterpret_cast<const int64_t*>(indices_)[offset];
+            break;
+        }
+
+        if (value < 0 || value >= array_->dictionary->length) {
+            throw Meta::ValidationError("Dictionary index out of range");
+        }
+
+        return value;
+    }
+
+    const struct ArrowSchema* index_schema_;
+
+  private:
+    std::unique_ptr<ArrayView> values_;
+    const uint8_t* indices_;
+    int index_width_;
+
+    // Dictionary indices are signed integers
+    static int parse_index_width(const char* format) {
+        if (strcmp(format, "c") == 0) {
+            return 1;
+        } else if (strcmp(format, "s") == 0) {
+            return 2;
+        } else if (strcmp(format, "i") == 0) {
+            return 4;
+        } else if (strcmp(format, "l") == 0) {
+            return 8;
+        } else {
+            throw Meta::ValidationError(
+                "Expected dictionary index format 'c', 's', 'i', or 'l'");
+        }
+    }
+};
+
+}
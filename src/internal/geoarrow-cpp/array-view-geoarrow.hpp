@@ -1,22 +1,153 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <vector>
+
 #include "meta.hpp"
 #include "handler.hpp"
 #include "array-view-base.hpp"
 
 namespace geoarrow {
 
+// A pull-style view of n consecutive coordinates in a PointArrayView's buffers
+// (i.e., nothing is copied). Coordinates that are not stored as doubles are
+// widened (and dequantized) as they are accessed. A CoordSpan is only
+// valid while the view and array it came from are valid.
+class CoordSpan {
+  public:
+    CoordSpan():
+      n_(0), coord_size_(0), separated_(false),
+      storage_type_(util::StorageType::Float64), scale_(nullptr), offset_(nullptr) {
+        for (int j = 0; j < 4; j++) {
+            lanes_[j] = nullptr;
+        }
+    }
+
+    CoordSpan(const void* const* lanes, int64_t n, int coord_size, bool separated,
+              util::StorageType storage_type, const double* scale, const double* offset):
+      n_(n), coord_size_(coord_size), separated_(separated),
+      storage_type_(storage_type), scale_(scale), offset_(offset) {
+        for (int j = 0; j < 4; j++) {
+            lanes_[j] = lanes[j];
+        }
+    }
+
+    int64_t size() const { return n_; }
+    int coord_size() const { return coord_size_; }
+
+    // Non-null if coordinates are interleaved doubles, in which case
+    // dimension j of coordinate i is data()[i * coord_size() + j]
+    const double* data() const {
+        if (!separated_ && storage_type_ == util::StorageType::Float64) {
+            return reinterpret_cast<const double*>(lanes_[0]);
+        } else {
+            return nullptr;
+        }
+    }
+
+    double x(int64_t i) const { return coord(i, 0); }
+    double y(int64_t i) const { return coord(i, 1); }
+
+    double coord(int64_t i, int j) const {
+        const void* lane = separated_ ? lanes_[j] : lanes_[0];
+        int64_t index = separated_ ? i : (i * coord_size_ + j);
+
+        switch (storage_type_) {
+        case util::StorageType::Float32:
+            return reinterpret_cast<const float*>(lane)[index] * scale_[j] + offset_[j];
+        case util::StorageType::Int32:
+            return reinterpret_cast<const int32_t*>(lane)[index] * scale_[j] + offset_[j];
+        case util::StorageType::Int16:
+            return reinterpret_cast<const int16_t*>(lane)[index] * scale_[j] + offset_[j];
+        default:
+            return reinterpret_cast<const double*>(lane)[index];
+        }
+    }
+
+  private:
+    const void* lanes_[4];
+    int64_t n_;
+    int coord_size_;
+    bool separated_;
+    util::StorageType storage_type_;
+    const double* scale_;
+    const double* offset_;
+};
+
+// The Feature returned by feature() for views whose features are a single
+// sequence of coordinates (i.e., points and linestrings)
+class CoordFeature {
+  public:
+    CoordFeature(const CoordSpan& coords): coords_(coords) {}
+
+    CoordSpan coords() const { return coords_; }
+
+  private:
+    CoordSpan coords_;
+};
+
 class PointArrayView: public ArrayView {
   public:
     PointArrayView(const struct ArrowSchema* schema):
-      ArrayView(schema), data_buffer_(nullptr) {
+      ArrayView(schema), data_buffer_(nullptr), n_lane_validity_(0) {
         coord_size_ = meta_.fixed_width_;
+        separated_ = meta_.coord_type_ == util::CoordType::Separate;
+        storage_type_ = meta_.coord_storage_type_;
+        for (int j = 0; j < 4; j++) {
+            lanes_[j] = nullptr;
+        }
     }
 
     void set_array(const struct ArrowArray* array) {
         ArrayView::set_array(array);
-        data_buffer_ = reinterpret_cast<const double*>(array->children[0]->buffers[1]);
+        n_lane_validity_ = 0;
+
+        if (separated_) {
+            // The offset of each child is applied here; the offset of the
+            // struct array is applied in read_coords()
+            int64_t item_size = storage_item_size();
+            for (int j = 0; j < coord_size_; j++) {
+                const struct ArrowArray* child = array->children[j];
+                lanes_[j] = reinterpret_cast<const uint8_t*>(child->buffers[1]) +
+                    child->offset * item_size;
+
+                if (child->buffers[0] != nullptr && child->null_count != 0) {
+                    lane_validity_[n_lane_validity_] =
+                        reinterpret_cast<const uint8_t*>(child->buffers[0]);
+                    lane_validity_offset_[n_lane_validity_] = child->offset;
+                    n_lane_validity_++;
+                }
+            }
+        } else {
+            data_buffer_ = array->children[0]->buffers[1];
+        }
+    }
+
+    // The children of a struct point may have their own validity (e.g.,
+    // when assembled from nullable x and y columns), in which case a point
+    // with any null coordinate is also null
+    bool is_null(int64_t offset) {
+        if (ArrayView::is_null(offset)) {
+            return true;
+        }
+
+        for (int j = 0; j < n_lane_validity_; j++) {
+            int64_t i = offset + array_->offset + lane_validity_offset_[j];
+            if ((lane_validity_[j][i / 8] & (0x01 << (i % 8))) == 0) {
+                return true;
+            }
+        }
+
+        return false;
+    }
+
+    // True if is_null() is false for every point in the array
+    bool has_no_nulls() {
+        return validity_buffer_ == nullptr && n_lane_validity_ == 0;
     }
 
     Handler::Result read_features(Handler* handler) {
@@ -37,41 +168,188 @@ class PointArrayView: public ArrayView {
 
     Handler::Result read_coords(Handler* handler, int64_t offset, int64_t n) {
         Handler::Result result;
+
+        switch (storage_type_) {
+        case util::StorageType::Float32:
+            return read_coords_widened<float>(handler, offset, n);
+        case util::StorageType::Int32:
+            return read_coords_widened<int32_t>(handler, offset, n);
+        case util::StorageType::Int16:
+            return read_coords_widened<int16_t>(handler, offset, n);
+        default:
+            break;
+        }
+
+        if (separated_) {
+            const double* lanes[4];
+            for (int j = 0; j < coord_size_; j++) {
+                lanes[j] = reinterpret_cast<const double*>(lanes_[j]) + offset + array_->offset;
+            }
+
+            HANDLE_OR_RETURN(handler->coords_separated(lanes, n, coord_size_));
+            return Handler::Result::CONTINUE;
+        }
+
         HANDLE_OR_RETURN(
             handler->coords(
-                data_buffer_ + (offset + array_->offset) * coord_size_,
+                reinterpret_cast<const double*>(data_buffer_) +
+                    (offset + array_->offset) * coord_size_,
                 n,
                 coord_size_));
         return Handler::Result::CONTINUE;
     }
 
+    typedef CoordFeature Feature;
+
+    Feature feature(int64_t offset) {
+        return Feature(coords(offset, 1));
+    }
+
+    CoordSpan coords(int64_t offset, int64_t n) {
+        int64_t item_size = storage_item_size();
+        const void* lanes[4];
+
+        if (separated_) {
+            for (int j = 0; j < coord_size_; j++) {
+                lanes[j] = reinterpret_cast<const uint8_t*>(lanes_[j]) +
+                    (offset + array_->offset) * item_size;
+            }
+        } else {
+            lanes[0] = reinterpret_cast<const uint8_t*>(data_buffer_) +
+                (offset + array_->offset) * coord_size_ * item_size;
+        }
+
+        return CoordSpan(lanes, n, coord_size_, separated_, storage_type_,
+                         meta_.scale_, meta_.offset_);
+    }
+
     int coord_size_;
-    const double* data_buffer_;
+    bool separated_;
+    util::StorageType storage_type_;
+    const void* data_buffer_;
+    const void* lanes_[4];
+
+  private:
+    int n_lane_validity_;
+    const uint8_t* lane_validity_[4];
+    int64_t lane_validity_offset_[4];
+
+    int64_t storage_item_size() {
+        switch (storage_type_) {
+        case util::StorageType::Float32: return sizeof(float);
+        case util::StorageType::Int32: return sizeof(int32_t);
+        case util::StorageType::Int16: return sizeof(int16_t);
+        default: return sizeof(double);
+        }
+    }
+
+    // Coordinates not stored as double are widened (and dequantized using
+    // the scale and offset from the metadata, which are 1 and 0 for
+    // floating-point storage) in fixed-size blocks so that handlers still
+    // see doubles
+    template <typename T>
+    Handler::Result read_coords_widened(Handler* handler, int64_t offset, int64_t n) {
+        // The common coord_sizes are dispatched to a compile-time constant so
+        // that the loop over dimensions can be unrolled
+        switch (coord_size_) {
+        case 2:
+            return read_coords_widened_templ<T, 2>(handler, offset, n);
+        case 3:
+            return read_coords_widened_templ<T, 3>(handler, offset, n);
+        case 4:
+            return read_coords_widened_templ<T, 4>(handler, offset, n);
+        default:
+            return read_coords_widened_templ<T, 0>(handler, offset, n);
+        }
+    }
+
+    // CoordSize is 0 if coord_size_ is not known at compile time
+    template <typename T, int CoordSize>
+    Handler::Result read_coords_widened_templ(Handler* handler, int64_t offset, int64_t n) {
+        const int coord_size = CoordSize == 0 ? coord_size_ : CoordSize;
+        static const int64_t block_size = 64;
+        double block[block_size * 4];
+        Handler::Result result;
+
+        // Local copies so that the compiler doesn't have to assume that
+        // writes to block modify them
+        double scale[4];
+        double scale_offset[4];
+        for (int j = 0; j < 4; j++) {
+            scale[j] = meta_.scale_[j];
+            scale_offset[j] = meta_.offset_[j];
+        }
+
+        for (int64_t block_start = 0; block_start < n; block_start += block_size) {
+            int64_t block_n = std::min<int64_t>(block_size, n - block_start);
+            int64_t first = offset + array_->offset + block_start;
+
+            if (separated_) {
+                const double* lanes[4];
+                for (int j = 0; j < coord_size; j++) {
+                    const T* src = reinterpret_cast<const T*>(lanes_[j]) + first;
+                    double* dst = block + j * block_size;
+                    for (int64_t i = 0; i < block_n; i++) {
+                        dst[i] = src[i] * scale[j] + scale_offset[j];
+                    }
+
+                    lanes[j] = dst;
+                }
+
+                HANDLE_OR_RETURN(handler->coords_separated(lanes, block_n, coord_size));
+            } else {
+                const T* src = reinterpret_cast<const T*>(data_buffer_) + first * coord_size;
+                for (int64_t i = 0; i < block_n; i++) {
+                    for (int j = 0; j < coord_size; j++) {
+                        block[i * coord_size + j] =
+                            src[i * coord_size + j] * scale[j] + scale_offset[j];
+                    }
+                }
+
+                HANDLE_OR_RETURN(handler->coords(block, block_n, coord_size));
+            }
+        }
+
+        return Handler::Result::CONTINUE;
+    }
 };
 
 
+// Reads both list ("+l") and large list ("+L") offsets. This is a
+// runtime check rather than a template parameter because each level of
+// nesting would otherwise double the number of views for a type.
 template <class ChildView>
 class ListArrayView: public ArrayView {
   public:
     ListArrayView(const struct ArrowSchema* schema):
-      ArrayView(schema), child_(schema->children[0]), offset_buffer_(nullptr) {}
+      ArrayView(schema), child_(schema->children[0]), offset_buffer_(nullptr),
+      large_offset_buffer_(nullptr) {}
 
     void set_array(const struct ArrowArray* array) {
         ArrayView::set_array(array);
         child_.set_array(array->children[0]);
-        offset_buffer_ = reinterpret_cast<const int32_t*>(array->buffers[1]);
+        if (meta_.storage_type_ == util::StorageType::LargeList) {
+            large_offset_buffer_ = reinterpret_cast<const int64_t*>(array->buffers[1]);
+        } else {
+            offset_buffer_ = reinterpret_cast<const int32_t*>(array->buffers[1]);
+        }
     }
 
-    int64_t child_offset(int32_t offset) {
-        return offset_buffer_[array_->offset + offset];
+    int64_t child_offset(int64_t offset) {
+        if (large_offset_buffer_ != nullptr) {
+            return large_offset_buffer_[array_->offset + offset];
+        } else {
+            return offset_buffer_[array_->offset + offset];
+        }
     }
 
-    int64_t child_size(int32_t offset) {
+    int64_t child_size(int64_t offset) {
         return child_offset(offset + 1) - child_offset(offset);
     }
 
     ChildView child_;
     const int32_t* offset_buffer_;
+    const int64_t* large_offset_buffer_;
 };
 
 
@@ -98,6 +376,12 @@ class LinestringArrayView: public ListArrayView<PointArrayView> {
         HANDLE_OR_RETURN(handler->geom_end());
         return Handler::Result::CONTINUE;
     }
+
+    typedef CoordFeature Feature;
+
+    Feature feature(int64_t offset) {
+        return Feature(this->child_.coords(this->child_offset(offset), this->child_size(offset)));
+    }
 };
 
 
@@ -137,6 +421,28 @@ class PolygonArrayView: public ListArrayView<ListArrayView<PointArrayView>> {
         return Handler::Result::CONTINUE;
     }
 
+    class Feature {
+      public:
+        Feature(PolygonArrayView* view, int64_t first_ring, int64_t num_rings):
+          view_(view), first_ring_(first_ring), num_rings_(num_rings) {}
+
+        int64_t num_rings() const { return num_rings_; }
+
+        CoordSpan ring(int64_t k) const {
+            ListArrayView<PointArrayView>& rings = view_->child_;
+            return rings.child_.coords(
+                rings.child_offset(first_ring_ + k), rings.child_size(first_ring_ + k));
+        }
+
+      private:
+        PolygonArrayView* view_;
+        int64_t first_ring_;
+        int64_t num_rings_;
+    };
+
+    Feature feature(int64_t offset) {
+        return Feature(this, this->child_offset(offset), this->child_size(offset));
+    }
 };
 
 
@@ -167,6 +473,168 @@ class CollectionArrayView: public ListArrayView<ChildView> {
         HANDLE_OR_RETURN(handler->geom_end());
         return Handler::Result::CONTINUE;
     }
+
+    class Feature {
+      public:
+        Feature(ChildView* child, int64_t first_part, int64_t num_parts):
+          child_(child), first_part_(first_part), num_parts_(num_parts) {}
+
+        int64_t num_parts() const { return num_parts_; }
+
+        typename ChildView::Feature part(int64_t j) const {
+            return child_->feature(first_part_ + j);
+        }
+
+      private:
+        ChildView* child_;
+        int64_t first_part_;
+        int64_t num_parts_;
+    };
+
+    Feature feature(int64_t offset) {
+        return Feature(&this->child_, this->child_offset(offset), this->child_size(offset));
+    }
+};
+
+
+// A dense union of native types (geoarrow.geometry) whose type ids select
+// the child array for each feature and whose offsets select the feature
+// within that child. Child views are dispatched with a switch on the child's
+// geometry type so that each call reaches a concrete read_geometry().
+class GeometryArrayView: public ArrayView {
+  public:
+    GeometryArrayView(const struct ArrowSchema* schema):
+      ArrayView(schema), type_ids_(nullptr), offsets_(nullptr) {
+        memset(child_index_, -1, sizeof(child_index_));
+
+        for (int64_t i = 0; i < schema->n_children; i++) {
+            Meta child_meta(schema->children[i]);
+            child_types_.push_back(child_meta.geometry_type_);
+            children_.push_back(
+                std::unique_ptr<ArrayView>(create_child(schema->children[i], child_meta)));
+        }
+
+        parse_type_ids(schema->format, schema->n_children);
+    }
+
+    void set_array(const struct ArrowArray* array) {
+        ArrayView::set_array(array);
+
+        // buffers[0] of a union array is its type ids (unions have no
+        // validity buffer)
+        validity_buffer_ = nullptr;
+        type_ids_ = reinterpret_cast<const int8_t*>(array->buffers[0]);
+        offsets_ = reinterpret_cast<const int32_t*>(array->buffers[1]);
+
+        for (size_t i = 0; i < children_.size(); i++) {
+            children_[i]->set_array(array->children[i]);
+        }
+    }
+
+    Handler::Result read_features(Handler* handler) {
+        return internal::read_features_templ<GeometryArrayView>(*this, handler);
+    }
+
+    Handler::Result read_feature(Handler* handler, int64_t offset) {
+        return internal::read_feature_templ<GeometryArrayView>(*this, offset, handler);
+    }
+
+    // A feature is null if it is null in its child. ArrayView::is_null() isn't
+    // virtual, so a point child has to be cast to check the validity of its
+    // struct children.
+    bool is_null(int64_t offset) {
+        int child = child_for(offset);
+        int64_t child_offset = offsets_[array_->offset + offset];
+        ArrayView* view = children_[child].get();
+
+        if (child_types_[child] == util::GeometryType::POINT) {
+            return static_cast<PointArrayView*>(view)->is_null(child_offset);
+        } else {
+            return view->is_null(child_offset);
+        }
+    }
+
+    Handler::Result read_geometry(Handler* handler, int64_t offset) {
+        int child = child_for(offset);
+        int64_t child_offset = offsets_[array_->offset + offset];
+        ArrayView* view = children_[child].get();
+
+        switch (child_types_[child]) {
+        case util::GeometryType::POINT:
+            return static_cast<PointArrayView*>(view)->read_geometry(handler, child_offset);
+        case util::GeometryType::LINESTRING:
+            return static_cast<LinestringArrayView*>(view)->read_geometry(handler, child_offset);
+        case util::GeometryType::POLYGON:
+            return static_cast<PolygonArrayView*>(view)->read_geometry(handler, child_offset);
+        case util::GeometryType::MULTIPOINT:
+            return static_cast<CollectionArrayView<PointArrayView>*>(view)->read_geometry(
+                handler, child_offset);
+        case util::GeometryType::MULTILINESTRING:
+            return static_cast<CollectionArrayView<LinestringArrayView>*>(view)->read_geometry(
+                handler, child_offset);
+        case util::GeometryType::MULTIPOLYGON:
+            return static_cast<CollectionArrayView<PolygonArrayView>*>(view)->read_geometry(
+                handler, child_offset);
+        default:
+            throw Meta::ValidationError("Unsupported child type for geoarrow.geometry");
+        }
+    }
+
+    const int8_t* type_ids_;
+    const int32_t* offsets_;
+
+  private:
+    std::vector<std::unique_ptr<ArrayView>> children_;
+    std::vector<util::GeometryType> child_types_;
+    // Type ids are between 0 and 127
+    int8_t child_index_[128];
+
+    static ArrayView* create_child(struct ArrowSchema* schema, const Meta& child_meta) {
+        switch (child_meta.geometry_type_) {
+        case util::GeometryType::POINT:
+            return new PointArrayView(schema);
+        case util::GeometryType::LINESTRING:
+            return new LinestringArrayView(schema);
+        case util::GeometryType::POLYGON:
+            return new PolygonArrayView(schema);
+        case util::GeometryType::MULTIPOINT:
+            return new CollectionArrayView<PointArrayView>(schema);
+        case util::GeometryType::MULTILINESTRING:
+            return new CollectionArrayView<LinestringArrayView>(schema);
+        case util::GeometryType::MULTIPOLYGON:
+            return new CollectionArrayView<PolygonArrayView>(schema);
+        default:
+            throw Meta::ValidationError("Unsupported child type for geoarrow.geometry");
+        }
+    }
+
+    // The format is "+ud:" followed by one comma-separated type id per child
+    void parse_type_ids(const char* format, int64_t n_children) {
+        const char* cursor = strchr(format, ':');
+        for (int64_t i = 0; i < n_children; i++) {
+            if (cursor == nullptr) {
+                throw Meta::ValidationError(
+                    "Expected one type id per child in geoarrow.geometry format");
+            }
+
+            long type_id = strtol(cursor + 1, nullptr, 10);
+            if (type_id < 0 || type_id > 127) {
+                throw Meta::ValidationError("Expected geoarrow.geometry type ids between 0 and 127");
+            }
+
+            child_index_[type_id] = static_cast<int8_t>(i);
+            cursor = strchr(cursor + 1, ',');
+        }
+    }
+
+    int child_for(int64_t offset) {
+        int8_t type_id = type_ids_[array_->offset + offset];
+        if (type_id < 0 || child_index_[type_id] < 0) {
+            throw util::IOException("Unexpected type id %d in geoarrow.geometry array", type_id);
+        }
+
+        return child_index_[type_id];
+    }
 };
 
 }
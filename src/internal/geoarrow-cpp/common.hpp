@@ -26,6 +26,8 @@ enum StorageType {
     Null,
     Float32,
     Float64,
+    Int16,
+    Int32,
     String,
     LargeString,
     FixedWidthBinary,
@@ -35,6 +37,7 @@ enum StorageType {
     Struct,
     List,
     LargeList,
+    DenseUnion,
     StorageTypeOther,
     StorageTypeNone
 };
@@ -54,6 +57,10 @@ enum Dimensions {DIMENSIONS_UNKNOWN = 10000, XY = 0, XYZ = 1000, XYM = 2000, XYZ
 
 enum Edges {Planar, Spherical, Ellipsoidal, EdgesUnknown};
 
+// Coordinates are either stored as a fixed-size list (xyxyxy...) or as a
+// struct with one child per dimension (xxx..., yyy...)
+enum CoordType {Interleaved, Separate, CoordTypeUnknown};
+
 class IOException: public arrow::hpp::util::Exception {
 public:
   IOException(const char* fmt, ...): arrow::hpp::util::Exception() {
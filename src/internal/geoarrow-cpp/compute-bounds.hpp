@@ -36,12 +36,38 @@ public:
     }
 
     void add_coords(const double* coord, int64_t n, int32_t coord_size) {
-        for (int64_t i = 0; i < n; i++) {
-            for (int32_t j = 0; j < coord_size; j++) {
-                double ordinate = coord[i * coord_size + j];
-                min_values_[j] = std::min<double>(min_values_[j], ordinate);
-                max_values_[j] = std::max<double>(max_values_[j], ordinate);
+        // The common coord_sizes are dispatched to a compile-time constant so
+        // that the loop over dimensions can be unrolled
+        switch (coord_size) {
+        case 2:
+            add_coords_templ<2>(coord, n, coord_size);
+            break;
+        case 3:
+            add_coords_templ<3>(coord, n, coord_size);
+            break;
+        case 4:
+            add_coords_templ<4>(coord, n, coord_size);
+            break;
+        default:
+            add_coords_templ<0>(coord, n, coord_size);
+            break;
+        }
+    }
+
+    // Each lane is a contiguous array of one dimension, which lets the
+    // compiler vectorize the inner loop
+    void add_coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        for (int32_t j = 0; j < coord_size; j++) {
+            const double* lane = lanes[j];
+            double min_value = min_values_[j];
+            double max_value = max_values_[j];
+            for (int64_t i = 0; i < n; i++) {
+                min_value = std::min<double>(min_value, lane[i]);
+                max_value = std::max<double>(max_value, lane[i]);
             }
+
+            min_values_[j] = min_value;
+            max_values_[j] = max_value;
         }
     }
 
@@ -82,6 +108,33 @@ private:
     int xyzm_map_[4];
     double min_values_[4];
     double max_values_[4];
+
+    // CoordSize is 0 if coord_size is not known at compile time
+    template <int CoordSize>
+    void add_coords_templ(const double* coord, int64_t n, int32_t coord_size) {
+        const int32_t size = CoordSize == 0 ? coord_size : CoordSize;
+
+        // Local copies so that the compiler can keep them in registers
+        double min_values[4];
+        double max_values[4];
+        for (int32_t j = 0; j < size; j++) {
+            min_values[j] = min_values_[j];
+            max_values[j] = max_values_[j];
+        }
+
+        for (int64_t i = 0; i < n; i++) {
+            for (int32_t j = 0; j < size; j++) {
+                double ordinate = coord[i * size + j];
+                min_values[j] = std::min<double>(min_values[j], ordinate);
+                max_values[j] = std::max<double>(max_values[j], ordinate);
+            }
+        }
+
+        for (int32_t j = 0; j < size; j++) {
+            min_values_[j] = min_values[j];
+            max_values_[j] = max_values[j];
+        }
+    }
 };
 
 }
@@ -125,6 +178,11 @@ public:
         return Result::CONTINUE;
     }
 
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        bounder_->add_coords_separated(lanes, n, coord_size);
+        return Result::CONTINUE;
+    }
+
     void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
         // Combine the two bounders into one happy global bound
         bounder_xyzm_.add_bounder(bounder_xym_);
@@ -5,10 +5,14 @@
 #include <limits>
 #include <cstring>
 #include <algorithm>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "handler.hpp"
 #include "common.hpp"
+#include "meta.hpp"
+#include "array-view-base.hpp"
 #include "internal/arrow-hpp/builder.hpp"
 
 namespace geoarrow {
@@ -38,6 +42,29 @@ public:
     }
   }
 
+  void set_int(const std::string& key, int64_t value) {
+    Item item;
+    item.type_ = Type::INT64;
+    item.int_ = value;
+    set_item(key, std::move(item));
+  }
+
+  int64_t get_int(const std::string& key) const {
+    const Item& item = get_item(key);
+    switch (item.type_) {
+    case Type::INT64: return item.int_;
+    default: throw util::IOException("Can't coerce key '%s' to INT64", key.c_str());
+    }
+  }
+
+  int64_t get_int(const std::string& key, int64_t default_value) const {
+    try {
+      return get_int(key);
+    } catch (util::IOException& e) {
+      return default_value;
+    }
+  }
+
   void set_schema(const std::string& key, struct ArrowSchema* value) {
     Item item;
     item.type_ = Type::SCHEMA;
@@ -53,19 +80,52 @@ public:
     }
   }
 
+  // Returns a copy of these options that owns a deep copy of each schema
+  // such that it can outlive the schemas passed to set_schema()
+  ComputeOptions deep_copy() const {
+    ComputeOptions out;
+    for (size_t i = 0; i < names_.size(); i++) {
+      Item item = values_[i];
+      if (item.type_ == Type::SCHEMA) {
+        item.owned_schema_ = std::shared_ptr<struct ArrowSchema>(
+          new struct ArrowSchema, &release_owned_schema);
+        item.owned_schema_->release = nullptr;
+        arrow::hpp::schema_deep_copy(item.schema_, item.owned_schema_.get());
+        item.schema_ = item.owned_schema_.get();
+      }
+
+      out.set_item(names_[i], item);
+    }
+
+    return out;
+  }
+
 private:
   enum Type {
     BOOL,
+    INT64,
     SCHEMA
   };
 
   class Item {
   public:
+    Item(): type_(Type::BOOL), bool_(false), int_(0), schema_(nullptr) {}
+
     Type type_;
     bool bool_;
+    int64_t int_;
     struct ArrowSchema* schema_;
+    std::shared_ptr<struct ArrowSchema> owned_schema_;
   };
 
+  static void release_owned_schema(struct ArrowSchema* schema) {
+    if (schema->release != nullptr) {
+      schema->release(schema);
+    }
+
+    delete schema;
+  }
+
   void set_item(const std::string& key, const Item& item) {
     names_.push_back(key);
     values_.push_back(std::move(item));
@@ -103,9 +163,48 @@ public:
     }
   }
 
+  // A hint that about n_coords coordinates will be written, for readers that
+  // know this before the first feature (e.g., from R matrix dimensions).
+  // Builders that don't store coordinates directly can ignore it.
+  virtual void reserve_coords(int64_t n_coords) {}
+
+  // Reads every feature of view (whose array has already been set) into
+  // this builder. Builders that can consume some views more directly than
+  // one feature's handler events at a time override this.
+  virtual Result read_view(ArrayView* view) {
+    return view->read_features(this);
+  }
+
 protected:
   struct ArrowSchema schema_out_;
 
+  // The coordinate layout (interleaved or separate), storage type, and
+  // quantization requested by the "schema" option (e.g., for "cast"). This
+  // is an empty Meta if there is no such option.
+  static Meta coord_meta(const ComputeOptions& options) {
+    try {
+      return Meta(options.get_schema("schema"));
+    } catch (std::exception& e) {
+      return Meta();
+    }
+  }
+
+  // True if schema (e.g., the "schema" option for "cast") requests int64
+  // list offsets, in which case builders use them from the start instead
+  // of promoting them when needed
+  static bool is_large_list(const struct ArrowSchema* schema) {
+    return schema != nullptr && schema->format != nullptr &&
+      std::string(schema->format) == "+L";
+  }
+
+  static const struct ArrowSchema* schema_option(const ComputeOptions& options) {
+    try {
+      return options.get_schema("schema");
+    } catch (std::exception& e) {
+      return nullptr;
+    }
+  }
+
   bool strict_schema() {
     return schema_out_.format != std::string("");
   }
@@ -123,6 +222,27 @@ protected:
   }
 };
 
+// Calls builder->release(). If the "memory_report" option is true, the
+// MemoryStats of the buffers released by the builder are added to the
+// output schema's metadata as "geoarrow:memory_report" (a JSON object).
+inline void release_builder(ComputeBuilder* builder, const ComputeOptions& options,
+                            struct ArrowArray* array_data, struct ArrowSchema* schema) {
+  if (!options.get_bool("memory_report", false)) {
+    builder->release(array_data, schema);
+    return;
+  }
+
+  arrow::hpp::builder::MemoryStats stats = builder->release_with_stats(array_data, schema);
+
+  std::string report = std::string("{") +
+    "\"n_buffers\": " + std::to_string(stats.n_buffers) +
+    ", \"peak_capacity_bytes\": " + std::to_string(stats.peak_capacity) +
+    ", \"size_bytes\": " + std::to_string(stats.size) +
+    ", \"slack_bytes\": " + std::to_string(stats.slack()) +
+    ", \"growth_steps\": " + std::to_string(stats.growth_steps) + "}";
+  arrow::hpp::schema_set_metadata_key(schema, "geoarrow:memory_report", report);
+}
+
 class NullBuilder: public ComputeBuilder {
 public:
   void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
@@ -32,12 +32,33 @@ public:
         default:
             throw util::IOException("Unknown ParentType");
         }
+
+        set_coord_layout(coord_meta(options));
+        set_offsets_like(schema_option(options));
+    }
+
+    void set_coord_layout(const Meta& meta) {
+        builder_.child().set_coord_layout(meta);
+    }
+
+    void set_offsets_like(const struct ArrowSchema* schema) {
+        if (is_large_list(schema)) {
+            builder_.make_large();
+        }
+
+        if (schema != nullptr && schema->n_children == 1) {
+            builder_.child().set_offsets_like(schema->children[0]);
+        }
     }
 
     void new_dimensions(util::Dimensions dimensions) {
         builder_.child().new_dimensions(dimensions);
     }
 
+    void reserve_coords(int64_t n_coords) {
+        builder_.child().reserve_coords(n_coords);
+    }
+
     Result feat_start() {
         level_ = 0;
         return Result::CONTINUE;
@@ -79,6 +100,10 @@ public:
         return builder_.child().coords(coord, n, coord_size);
     }
 
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        return builder_.child().coords_separated(lanes, n, coord_size);
+    }
+
     Result ring_end() {
         return builder_.child().ring_end();
     }
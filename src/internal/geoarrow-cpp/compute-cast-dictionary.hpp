@@ -0,0 +1,167 @@
+
+#pragma once
+
+#include <cstdlib>
+#include <limits>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+
+#include "handler.hpp"
+#include "compute-builder.hpp"
+#include "compute-feature-hash.hpp"
+#include "internal/arrow-hpp/builder.hpp"
+
+namespace geoarrow {
+
+// Builds a dictionary-encoded array whose dictionary contains each unique
+// feature once and whose int32 indices point into the dictionary. Each feature
+// is recorded, hashed, and compared to the unique features with the same
+// hash; only features that haven't been seen before are written to the
+// dictionary builder. The unique features are kept until release() to
+// resolve hash collisions, so this is only a good idea when features are
+// repeated (e.g., boundaries joined to many rows). Null features have a
+// null index.
+class DictionaryArrayBuilder: public ComputeBuilder {
+public:
+    // values builds the dictionary
+    DictionaryArrayBuilder(std::unique_ptr<ComputeBuilder> values, const ComputeOptions& options):
+        ComputeBuilder(options), values_(std::move(values)) {}
+
+    void new_schema(const ArrowSchema* schema) {
+        values_->new_schema(schema);
+    }
+
+    void new_geometry_type(util::GeometryType geometry_type) {
+        values_->new_geometry_type(geometry_type);
+    }
+
+    void new_dimensions(util::Dimensions dimensions) {
+        recorder_.new_dimensions(dimensions);
+        values_->new_dimensions(dimensions);
+    }
+
+    Result array_start(const struct ArrowArray* array_data) {
+        return values_->array_start(array_data);
+    }
+
+    Result feat_start() {
+        return recorder_.feat_start();
+    }
+
+    Result null_feat() {
+        indices_.write_null();
+        size_++;
+        return Result::ABORT_FEATURE;
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        return recorder_.geom_start(geometry_type, size);
+    }
+
+    Result ring_start(int32_t size) {
+        return recorder_.ring_start(size);
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        return recorder_.coords(coord, n, coord_size);
+    }
+
+    Result ring_end() {
+        return recorder_.ring_end();
+    }
+
+    Result geom_end() {
+        return recorder_.geom_end();
+    }
+
+    Result feat_end() {
+        std::vector<int32_t>& candidates = unique_by_hash_[recorder_.hash()];
+        for (int32_t index: candidates) {
+            if (unique_[index].equals(recorder_)) {
+                indices_.write_element(index);
+                size_++;
+                return Result::CONTINUE;
+            }
+        }
+
+        if (unique_.size() >= static_cast<size_t>(std::numeric_limits<int32_t>::max())) {
+            throw util::IOException("Too many unique features for int32 dictionary indices");
+        }
+
+        // ABORT_FEATURE from the values builder means that it has finished
+        // writing this feature early (e.g., an EMPTY linestring), not that
+        // nothing was written, so the feature still gets a dictionary entry
+        Result result = recorder_.replay(values_.get());
+        if (result == Result::ABORT) {
+            return result;
+        }
+
+        int32_t index = static_cast<int32_t>(unique_.size());
+        candidates.push_back(index);
+        util::Dimensions dimensions = recorder_.dimensions();
+        unique_.push_back(std::move(recorder_));
+        recorder_ = FeatureRecorder();
+        recorder_.new_dimensions(dimensions);
+
+        indices_.write_element(index);
+        size_++;
+        return Result::CONTINUE;
+    }
+
+    Result array_end() {
+        return values_->array_end();
+    }
+
+    void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+        struct ArrowArray* dictionary_data = nullptr;
+        struct ArrowSchema* dictionary_schema = nullptr;
+
+        try {
+            dictionary_data = allocate<struct ArrowArray>();
+            dictionary_schema = allocate<struct ArrowSchema>();
+            values_->release(dictionary_data, dictionary_schema);
+            indices_.shrink();
+            indices_.release(array_data, schema);
+        } catch (std::exception& e) {
+            if (dictionary_data != nullptr && dictionary_data->release != nullptr) {
+                dictionary_data->release(dictionary_data);
+            }
+
+            if (dictionary_schema != nullptr && dictionary_schema->release != nullptr) {
+                dictionary_schema->release(dictionary_schema);
+            }
+
+            free(dictionary_data);
+            free(dictionary_schema);
+            throw;
+        }
+
+        // The index array and schema own the dictionary array and schema
+        // (i.e., their release callbacks release and free() them)
+        array_data->dictionary = dictionary_data;
+        schema->dictionary = dictionary_schema;
+
+        finish_schema(schema);
+    }
+
+private:
+    std::unique_ptr<ComputeBuilder> values_;
+    arrow::hpp::builder::Int32ArrayBuilder indices_;
+    FeatureRecorder recorder_;
+    std::vector<FeatureRecorder> unique_;
+    std::unordered_map<uint64_t, std::vector<int32_t>> unique_by_hash_;
+
+    template <typename T>
+    static T* allocate() {
+        T* out = reinterpret_cast<T*>(malloc(sizeof(T)));
+        if (out == nullptr) {
+            throw util::IOException("Failed to allocate dictionary");
+        }
+
+        out->release = nullptr;
+        return out;
+    }
+};
+
+}
@@ -0,0 +1,273 @@
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "handler.hpp"
+#include "schema.hpp"
+#include "compute-builder.hpp"
+#include "compute-cast-point.hpp"
+#include "compute-cast-linestring.hpp"
+#include "compute-cast-polygon.hpp"
+#include "compute-cast-collection.hpp"
+#include "internal/arrow-hpp/builder.hpp"
+
+namespace geoarrow {
+
+// Builds a dense union of native types (geoarrow.geometry), routing each
+// feature to the child builder for its geometry type. The children and
+// their type ids are those of the "schema" option if it is a
+// geoarrow.geometry; otherwise there is one child per geometry type
+// (point through multipolygon) whose type id is the geometry type code.
+// Single geometries are written to the corresponding multi child if there
+// is no child for their own type.
+// Null features are written as a null in the point child (or the first
+// child if there is no point child) because unions have no validity buffer.
+class GeometryArrayBuilder: public ComputeBuilder {
+public:
+    GeometryArrayBuilder(const ComputeOptions& options = ComputeOptions()):
+      ComputeBuilder(options), level_(0), current_(-1), null_child_(0) {
+        memset(child_for_type_, -1, sizeof(child_for_type_));
+
+        ComputeOptions child_options;
+        child_options.set_bool("null_is_empty", options.get_bool("null_is_empty", false));
+
+        const struct ArrowSchema* schema = schema_option(options);
+        Meta meta = coord_meta(options);
+        if (schema != nullptr && meta.extension_ == util::Extension::Geometry) {
+            std::vector<int8_t> type_ids = parse_type_ids(schema->format, schema->n_children);
+            for (int64_t i = 0; i < schema->n_children; i++) {
+                Meta child_meta(schema->children[i]);
+                add_child(child_meta.geometry_type_, type_ids[i], schema->children[i]->name,
+                          child_meta, schema->children[i], child_options);
+            }
+        } else {
+            const char* names[] = {"point", "linestring", "polygon", "multipoint",
+                                   "multilinestring", "multipolygon"};
+            for (int i = 0; i < 6; i++) {
+                add_child(static_cast<util::GeometryType>(i + 1), static_cast<int8_t>(i + 1),
+                          names[i], meta, nullptr, child_options);
+            }
+        }
+
+        if (child_for_type_[util::GeometryType::POINT] != -1) {
+            null_child_ = child_for_type_[util::GeometryType::POINT];
+        }
+    }
+
+    void new_dimensions(util::Dimensions dimensions) {
+        for (auto& child: children_) {
+            child.builder->new_dimensions(dimensions);
+        }
+    }
+
+    Result feat_start() {
+        level_ = 0;
+        current_ = -1;
+        return Result::CONTINUE;
+    }
+
+    Result null_feat() {
+        start_child(null_child_);
+        return children_[current_].builder->null_feat();
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        level_++;
+        if (level_ > 1) {
+            return children_[current_].builder->geom_start(geometry_type, size);
+        }
+
+        int child = -1;
+        if (geometry_type >= 0 && geometry_type < 8) {
+            child = child_for_type_[geometry_type];
+        }
+
+        // e.g., a point can be written to a multipoint child
+        if (child == -1 && geometry_type >= util::GeometryType::POINT &&
+                geometry_type <= util::GeometryType::POLYGON) {
+            child = child_for_type_[geometry_type + 3];
+        }
+
+        if (child == -1) {
+            throw util::IOException(
+                "Can't write geometry type %d as geoarrow.geometry", geometry_type);
+        }
+
+        start_child(child);
+        return children_[current_].builder->geom_start(geometry_type, size);
+    }
+
+    Result ring_start(int32_t size) {
+        return children_[current_].builder->ring_start(size);
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        return children_[current_].builder->coords(coord, n, coord_size);
+    }
+
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        return children_[current_].builder->coords_separated(lanes, n, coord_size);
+    }
+
+    Result ring_end() {
+        return children_[current_].builder->ring_end();
+    }
+
+    Result geom_end() {
+        level_--;
+        return children_[current_].builder->geom_end();
+    }
+
+    Result feat_end() {
+        if (current_ == -1) {
+            throw util::IOException("Can't write feature without geometry as geoarrow.geometry");
+        }
+
+        return children_[current_].builder->feat_end();
+    }
+
+    void shrink() {
+        ArrayBuilder::shrink();
+        type_id_buffer_builder_.shrink();
+        offset_buffer_builder_.shrink();
+    }
+
+    void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+        shrink();
+
+        arrow::hpp::builder::CArrayFinalizer finalizer;
+        finalizer.allocate(2, children_.size());
+
+        std::string format = "+ud:";
+        for (size_t i = 0; i < children_.size(); i++) {
+            format += (i > 0 ? "," : "") + std::to_string(children_[i].type_id);
+        }
+
+        std::vector<std::string> metadata_names = {
+            "ARROW:extension:name", "ARROW:extension:metadata"};
+        std::vector<std::string> metadata_values = {
+            "geoarrow.geometry", Metadata().build()};
+
+        finalizer.set_schema_format(format.c_str());
+        finalizer.set_schema_name(name().c_str());
+        finalizer.set_schema_metadata(metadata_names, metadata_values);
+
+        finalizer.array_data.length = size();
+        finalizer.array_data.null_count = 0;
+        finalizer.array_data.buffers[0] = type_id_buffer_builder_.release();
+        finalizer.array_data.buffers[1] = offset_buffer_builder_.release();
+
+        for (size_t i = 0; i < children_.size(); i++) {
+            children_[i].builder->set_name(children_[i].name);
+            children_[i].builder->release(
+                finalizer.array_data.children[i],
+                finalizer.schema->children[i]);
+        }
+
+        finalizer.release(array_data, schema);
+
+        // checks output and copies metadata
+        finish_schema(schema);
+    }
+
+private:
+    struct Child {
+        util::GeometryType geometry_type;
+        int8_t type_id;
+        std::string name;
+        std::unique_ptr<ComputeBuilder> builder;
+        int64_t size;
+    };
+
+    int level_;
+    int current_;
+    int null_child_;
+    std::vector<Child> children_;
+    int child_for_type_[8];
+    arrow::hpp::builder::BufferBuilder<int8_t> type_id_buffer_builder_;
+    arrow::hpp::builder::BufferBuilder<int32_t> offset_buffer_builder_;
+
+    // Writes the type id and offset for the current feature
+    void start_child(int child) {
+        current_ = child;
+        Child& item = children_[child];
+        if (item.size >= std::numeric_limits<int32_t>::max()) {
+            throw util::IOException(
+                "Can't write more than %d features to one geoarrow.geometry child",
+                std::numeric_limits<int32_t>::max());
+        }
+
+        type_id_buffer_builder_.write_element(item.type_id);
+        offset_buffer_builder_.write_element(static_cast<int32_t>(item.size));
+        item.size++;
+        size_++;
+
+        item.builder->feat_start();
+    }
+
+    void add_child(util::GeometryType geometry_type, int8_t type_id, const char* name,
+                   const Meta& meta, const struct ArrowSchema* schema,
+                   const ComputeOptions& child_options) {
+        Child child;
+        child.geometry_type = geometry_type;
+        child.type_id = type_id;
+        child.name = name == nullptr ? "" : name;
+        child.size = 0;
+
+        switch (geometry_type) {
+        case util::GeometryType::POINT:
+            child.builder.reset(make_child<PointArrayBuilder>(meta, schema, child_options));
+            break;
+        case util::GeometryType::LINESTRING:
+            child.builder.reset(make_child<LinestringArrayBuilder>(meta, schema, child_options));
+            break;
+        case util::GeometryType::POLYGON:
+            child.builder.reset(make_child<PolygonArrayBuilder>(meta, schema, child_options));
+            break;
+        case util::GeometryType::MULTIPOINT:
+            child.builder.reset(make_child<MultiPointArrayBuilder>(meta, schema, child_options));
+            break;
+        case util::GeometryType::MULTILINESTRING:
+            child.builder.reset(make_child<MultiLinestringArrayBuilder>(meta, schema, child_options));
+            break;
+        case util::GeometryType::MULTIPOLYGON:
+            child.builder.reset(make_child<MultiPolygonArrayBuilder>(meta, schema, child_options));
+            break;
+        default:
+            throw util::IOException("Unsupported child type for geoarrow.geometry");
+        }
+
+        child_for_type_[geometry_type] = children_.size();
+        children_.push_back(std::move(child));
+    }
+
+    template <typename Builder>
+    static ComputeBuilder* make_child(const Meta& meta, const struct ArrowSchema* schema,
+                                      const ComputeOptions& child_options) {
+        std::unique_ptr<Builder> builder(new Builder(child_options));
+        builder->set_coord_layout(meta);
+        builder->set_offsets_like(schema);
+        return builder.release();
+    }
+
+    static std::vector<int8_t> parse_type_ids(const char* format, int64_t n_children) {
+        std::vector<int8_t> type_ids;
+        const char* cursor = strchr(format, ':');
+        for (int64_t i = 0; i < n_children; i++) {
+            if (cursor == nullptr) {
+                throw util::IOException(
+                    "Expected one type id per child in geoarrow.geometry format");
+            }
+
+            type_ids.push_back(static_cast<int8_t>(strtol(cursor + 1, nullptr, 10)));
+            cursor = strchr(cursor + 1, ',');
+        }
+
+        return type_ids;
+    }
+};
+
+}
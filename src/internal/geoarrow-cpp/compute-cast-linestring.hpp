@@ -15,12 +15,28 @@ public:
     LinestringArrayBuilder(const ComputeOptions& options = ComputeOptions()):
       ComputeBuilder(options) {
         builder_.child().set_name("vertices");
+        set_coord_layout(coord_meta(options));
+        set_offsets_like(schema_option(options));
+    }
+
+    void set_coord_layout(const Meta& meta) {
+        builder_.child().set_coord_layout(meta);
+    }
+
+    void set_offsets_like(const struct ArrowSchema* schema) {
+        if (is_large_list(schema)) {
+            builder_.make_large();
+        }
     }
 
     void new_dimensions(util::Dimensions dimensions) {
         builder_.child().new_dimensions(dimensions);
     }
 
+    void reserve_coords(int64_t n_coords) {
+        builder_.child().reserve(n_coords);
+    }
+
     Result null_feat() {
         size_++;
         builder_.finish_element(false);
@@ -48,6 +64,10 @@ public:
         return builder_.child().coords(coord, n, coord_size);
     }
 
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        return builder_.child().coords_separated(lanes, n, coord_size);
+    }
+
     Result feat_end() {
         size_++;
         builder_.finish_element();
@@ -2,10 +2,14 @@
 #pragma once
 
 #include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string>
 #include <vector>
 
 #include "handler.hpp"
 #include "schema.hpp"
+#include "array-view-geoarrow.hpp"
 #include "compute-builder.hpp"
 #include "internal/arrow-hpp/builder.hpp"
 #include "internal/arrow-hpp/builder-list.hpp"
@@ -22,8 +26,10 @@ public:
       builder_xyz_(3),
       builder_xym_(3),
       builder_xyzm_(4),
-      builder_(&builder_xy_) {
+      builder_(&builder_xy_),
+      separated_(false) {
         null_is_empty_ = options.get_bool("null_is_empty", false);
+        set_coord_layout(coord_meta(options));
 
         builder_xy_.child().set_name("xy");
         builder_xyz_.child().set_name("xyz");
@@ -31,13 +37,68 @@ public:
         builder_xyzm_.child().set_name("xyzm");
     }
 
+    // Points have no offsets (for symmetry with the other builders, which
+    // can be the child of a MultiArrayBuilder)
+    void set_offsets_like(const struct ArrowSchema* schema) {}
+
+    // Use the coordinate layout of a point Meta (or the Meta of any type
+    // whose coordinates are points), which may specify a struct with one
+    // child per dimension instead of a fixed-size list, a float or
+    // integer storage type, and the scale and offset for integer storage
+    void set_coord_layout(const Meta& meta) {
+        separated_ = meta.coord_type_ == util::CoordType::Separate;
+
+        switch (meta.coord_storage_type_) {
+        case util::StorageType::Float32:
+            storage_ = arrow::hpp::builder::NumericArrayBuilder::Storage::FLOAT;
+            break;
+        case util::StorageType::Int32:
+            storage_ = arrow::hpp::builder::NumericArrayBuilder::Storage::INT32;
+            break;
+        case util::StorageType::Int16:
+            storage_ = arrow::hpp::builder::NumericArrayBuilder::Storage::INT16;
+            break;
+        default:
+            storage_ = arrow::hpp::builder::NumericArrayBuilder::Storage::DOUBLE;
+            break;
+        }
+
+        memcpy(scale_, meta.scale_, sizeof(scale_));
+        memcpy(offset_, meta.offset_, sizeof(offset_));
+
+        builder_xy_.child().set_storage(storage_, scale_, offset_, 2);
+        builder_xyz_.child().set_storage(storage_, scale_, offset_, 3);
+        builder_xym_.child().set_storage(storage_, scale_, offset_, 3);
+        builder_xyzm_.child().set_storage(storage_, scale_, offset_, 4);
+        for (int j = 0; j < 4; j++) {
+            lanes_[j].set_storage(storage_, scale_ + j, offset_ + j);
+        }
+    }
+
     void reserve(int64_t additional_capacity) {
-        builder_->reserve(additional_capacity);
+        if (separated_) {
+            ArrayBuilder::reserve(additional_capacity);
+            for (int64_t j = 0; j < builder_->item_size(); j++) {
+                lanes_[j].reserve(additional_capacity);
+            }
+        } else {
+            builder_->reserve(additional_capacity);
+        }
+    }
+
+    void reserve_coords(int64_t n_coords) {
+        reserve(n_coords);
     }
 
     void shrink() {
         ArrayBuilder::shrink();
-        builder_->shrink();
+        if (separated_) {
+            for (int j = 0; j < 4; j++) {
+                lanes_[j].shrink();
+            }
+        } else {
+            builder_->shrink();
+        }
     }
 
     void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
@@ -46,10 +107,16 @@ public:
                 "Point builder with multiple dimensions not implemented");
         }
 
+        if (separated_) {
+            release_separated(array_data, schema);
+            finish_schema(schema);
+            return;
+        }
+
         shrink();
         builder_->set_name(name());
         builder_->set_metadata("ARROW:extension:name", "geoarrow.point");
-        builder_->set_metadata("ARROW:extension:metadata", Metadata().build());
+        builder_->set_metadata("ARROW:extension:metadata", build_metadata());
         builder_->release(array_data, schema);
 
         // checks output and copies metadata
@@ -57,6 +124,10 @@ public:
     }
 
     const char* get_format() {
+        if (separated_) {
+            return "+s";
+        }
+
         return builder_->get_format();
     }
 
@@ -85,8 +156,23 @@ public:
     }
 
     Result null_feat() {
-        double empty_coord[] = {NAN, NAN, NAN, NAN};
-        builder_->child().write_buffer(empty_coord, builder_->item_size());
+        // Integer coordinates have no value that reads back as empty
+        if (null_is_empty_ && is_integer_storage()) {
+            throw util::IOException(
+                "Can't write null point as empty with integer coordinate storage");
+        }
+
+        if (separated_) {
+            for (int64_t j = 0; j < builder_->item_size(); j++) {
+                lanes_[j].write_empty(1);
+            }
+
+            validity_buffer_builder_.write_element(null_is_empty_);
+            size_++;
+            return Result::ABORT_FEATURE;
+        }
+
+        builder_->child().write_empty(builder_->item_size());
         builder_->finish_elements(1, null_is_empty_);
         size_++;
         return Result::ABORT_FEATURE;
@@ -94,6 +180,11 @@ public:
 
     Result geom_start(util::GeometryType geometry_type, int32_t size) {
         if (size == 0) {
+            if (is_integer_storage()) {
+                throw util::IOException(
+                    "Can't write POINT EMPTY with integer coordinate storage");
+            }
+
             double empty_coord[] = {NAN, NAN, NAN, NAN};
             coords(empty_coord, 1, builder_->item_size());
             return Result::CONTINUE;
@@ -107,23 +198,164 @@ public:
     }
 
     Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        if (separated_) {
+            write_separated(coord, n, coord_size);
+            validity_buffer_builder_.write_elements(n, true);
+            size_ += n;
+            return Result::CONTINUE;
+        }
+
         builder_->child().write_buffer(coord, n * coord_size);
         builder_->finish_elements(n);
         size_ += n;
         return Result::CONTINUE;
     }
 
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        if (!separated_) {
+            builder_->child().write_interleaved(lanes, n, coord_size);
+            builder_->finish_elements(n);
+            size_ += n;
+            return Result::CONTINUE;
+        }
+
+        for (int32_t j = 0; j < coord_size; j++) {
+            lanes_[j].write_buffer(lanes[j], n);
+        }
+
+        validity_buffer_builder_.write_elements(n, true);
+        size_ += n;
+        return Result::CONTINUE;
+    }
+
+    // A point array (in either coordinate layout) is read as runs of
+    // non-null points, each of which is written as a single block of
+    // coordinates instead of one feature at a time. This makes changing the
+    // layout (or storage type) of a large point array about as fast as
+    // copying its buffers.
+    Result read_view(ArrayView* view) {
+        // Other views (including a DictionaryArrayView of points, whose meta_
+        // is that of its point dictionary) are read one feature at a time
+        PointArrayView* point_view = dynamic_cast<PointArrayView*>(view);
+        if (point_view == nullptr) {
+            return ComputeBuilder::read_view(view);
+        }
+
+        const int64_t n = point_view->array_->length;
+        Result result;
+
+        HANDLE_OR_RETURN(array_start(point_view->array_));
+        reserve(n);
+
+        if (point_view->has_no_nulls()) {
+            if (n > 0) {
+                HANDLE_OR_RETURN(point_view->read_coords(this, 0, n));
+            }
+
+            return array_end();
+        }
+
+        int64_t i = 0;
+        while (i < n) {
+            if (point_view->is_null(i)) {
+                null_feat();
+                i++;
+                continue;
+            }
+
+            int64_t end = i + 1;
+            while (end < n && !point_view->is_null(end)) {
+                end++;
+            }
+
+            HANDLE_OR_RETURN(point_view->read_coords(this, i, end - i));
+            i = end;
+        }
+
+        return array_end();
+    }
+
 private:
-    using Float64ListBuilder =
-        arrow::hpp::builder::FixedSizeListArrayBuilder<arrow::hpp::builder::Float64ArrayBuilder>;
+    using CoordListBuilder =
+        arrow::hpp::builder::FixedSizeListArrayBuilder<arrow::hpp::builder::NumericArrayBuilder>;
     bool null_is_empty_;
     util::Dimensions dimensions_;
-    Float64ListBuilder builder_xy_;
-    Float64ListBuilder builder_xyz_;
-    Float64ListBuilder builder_xym_;
-    Float64ListBuilder builder_xyzm_;
-    Float64ListBuilder* builder_;
+    CoordListBuilder builder_xy_;
+    CoordListBuilder builder_xyz_;
+    CoordListBuilder builder_xym_;
+    CoordListBuilder builder_xyzm_;
+    CoordListBuilder* builder_;
     std::vector<std::pair<util::Dimensions, int64_t>> ranges_;
+
+    // Used instead of builder_ when separated_ is true. The number of
+    // lanes used is the item size of builder_.
+    bool separated_;
+    arrow::hpp::builder::NumericArrayBuilder lanes_[4];
+
+    arrow::hpp::builder::NumericArrayBuilder::Storage storage_;
+    double scale_[4];
+    double offset_[4];
+
+    bool is_integer_storage() {
+        return storage_ == arrow::hpp::builder::NumericArrayBuilder::Storage::INT32 ||
+            storage_ == arrow::hpp::builder::NumericArrayBuilder::Storage::INT16;
+    }
+
+    std::string build_metadata() {
+        Metadata metadata;
+        if (is_integer_storage()) {
+            metadata.set("scale", format_per_dimension(scale_));
+            metadata.set("offset", format_per_dimension(offset_));
+        }
+
+        return metadata.build();
+    }
+
+    std::string format_per_dimension(const double* values) {
+        std::string out;
+        char buf[64];
+        for (int64_t j = 0; j < builder_->item_size(); j++) {
+            snprintf(buf, sizeof(buf), j == 0 ? "%.17g" : " %.17g", values[j]);
+            out += buf;
+        }
+
+        return out;
+    }
+
+    void write_separated(const double* coord, int64_t n, int32_t coord_size) {
+        arrow::hpp::builder::NumericArrayBuilder::write_deinterleaved(
+            lanes_, coord, n, coord_size);
+    }
+
+    void release_separated(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+        shrink();
+
+        // e.g., "xyz" -> children named "x", "y", and "z"
+        const std::string& dim = builder_->child().name();
+        int64_t n_lanes = builder_->item_size();
+
+        arrow::hpp::builder::CArrayFinalizer finalizer;
+        finalizer.allocate(1, n_lanes);
+        finalizer.set_schema_format("+s");
+        finalizer.set_schema_name(name().c_str());
+
+        set_metadata("ARROW:extension:name", "geoarrow.point");
+        set_metadata("ARROW:extension:metadata", build_metadata());
+        finalizer.set_schema_metadata(metadata_names_, metadata_values_);
+
+        finalizer.array_data.length = size();
+        finalizer.array_data.null_count = validity_buffer_builder_.null_count();
+        finalizer.array_data.buffers[0] = validity_buffer_builder_.release();
+
+        for (int64_t j = 0; j < n_lanes; j++) {
+            lanes_[j].set_name(dim.substr(j, 1));
+            lanes_[j].release(
+                finalizer.array_data.children[j],
+                finalizer.schema->children[j]);
+        }
+
+        finalizer.release(array_data, schema);
+    }
 };
 
 }
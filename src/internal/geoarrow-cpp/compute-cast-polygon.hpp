@@ -15,12 +15,33 @@ public:
     PolygonArrayBuilder(const ComputeOptions& options = ComputeOptions()): ComputeBuilder(options) {
         builder_.child().set_name("rings");
         builder_.child().child().set_name("vertices");
+        set_coord_layout(coord_meta(options));
+        set_offsets_like(schema_option(options));
+    }
+
+    void set_coord_layout(const Meta& meta) {
+        builder_.child().child().set_coord_layout(meta);
+    }
+
+    void set_offsets_like(const struct ArrowSchema* schema) {
+        if (is_large_list(schema)) {
+            builder_.make_large();
+        }
+
+        if (schema != nullptr && schema->n_children == 1 &&
+                is_large_list(schema->children[0])) {
+            builder_.child().make_large();
+        }
     }
 
     void new_dimensions(util::Dimensions dimensions) {
         builder_.child().child().new_dimensions(dimensions);
     }
 
+    void reserve_coords(int64_t n_coords) {
+        builder_.child().child().reserve(n_coords);
+    }
+
     Result null_feat() {
         size_++;
         builder_.finish_element(false);
@@ -56,6 +77,10 @@ public:
         return builder_.child().child().coords(coord, n, coord_size);
     }
 
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        return builder_.child().child().coords_separated(lanes, n, coord_size);
+    }
+
     Result ring_end() {
         builder_.child().finish_element();
         return Result::CONTINUE;
@@ -14,14 +14,23 @@
 
 namespace geoarrow {
 
+// Writes WKB using the byte order of the host unless the "endian" option is
+// 0 (big endian) or 1 (little endian), in which case values are swapped as
+// they are written if needed.
 class WKBArrayBuilder: public ComputeBuilder {
 public:
     WKBArrayBuilder(const ComputeOptions& options):
       ComputeBuilder(options),
-      endian_(0x01),
       dimensions_(util::Dimensions::XY) {
         stack_.reserve(32);
 
+        int64_t endian = options.get_int("endian", native_endian());
+        if (endian != 0x00 && endian != 0x01) {
+            throw util::IOException("Expected endian = 0 or 1 but got %lld", (long long) endian);
+        }
+        endian_ = endian;
+        swapping_ = endian_ != native_endian();
+
         // make large immediately if requested
         if (schema_out_.format == std::string("Z")) {
             string_builder_.make_large();
@@ -78,7 +87,7 @@ public:
         // the choices for the Dimensions Enum values were 100% fudged to
         // simplify this line of code
         uint32_t geometry_type_to_write = dimensions_ + geometry_type;
-        memcpy(string_builder_.data_at_cursor(), &geometry_type_to_write, sizeof(uint32_t));
+        write_uint32(string_builder_.data_at_cursor(), geometry_type_to_write);
         string_builder_.advance_data(sizeof(uint32_t));
 
         // If we're reading WKT and maybe some future data source that also
@@ -135,7 +144,14 @@ public:
 
         int64_t n_bytes = sizeof(double) * n * coord_size;
         string_builder_.reserve_data(n_bytes);
-        memcpy(string_builder_.data_at_cursor(), coord, n_bytes);
+        if (swapping_) {
+            uint8_t* dst = string_builder_.data_at_cursor();
+            for (int64_t i = 0; i < (n * coord_size); i++) {
+                write_swapped(dst + i * sizeof(double), coord + i);
+            }
+        } else {
+            memcpy(string_builder_.data_at_cursor(), coord, n_bytes);
+        }
         string_builder_.advance_data(n_bytes);
 
         return Result::CONTINUE;
@@ -143,10 +159,9 @@ public:
 
     Result ring_end() {
         if (stack_.size() > 0) {
-            memcpy(
+            write_uint32(
                 string_builder_.mutable_data() + stack_.back().data_buffer_position,
-                &stack_.back().size,
-                sizeof(uint32_t));
+                stack_.back().size);
             stack_.pop_back();
         }
         return Result::CONTINUE;
@@ -154,10 +169,9 @@ public:
 
     Result geom_end() {
         if (stack_.size() > 0 && stack_.back().geometry_type != util::GeometryType::POINT) {
-            memcpy(
+            write_uint32(
                 string_builder_.mutable_data() + stack_.back().data_buffer_position,
-                &stack_.back().size,
-                sizeof(uint32_t));
+                stack_.back().size);
         }
 
         if (stack_.size() > 0) {
@@ -181,9 +195,34 @@ private:
     };
 
     uint8_t endian_;
+    bool swapping_;
     arrow::hpp::builder::BinaryArrayBuilder string_builder_;
     std::vector<State> stack_;
     util::Dimensions dimensions_;
+
+    // 0x01 (little endian) or 0x00 (big endian), as WKB would write it
+    static uint8_t native_endian() {
+        uint32_t one = 1;
+        uint8_t first_byte;
+        memcpy(&first_byte, &one, sizeof(uint8_t));
+        return first_byte;
+    }
+
+    void write_uint32(uint8_t* dst, uint32_t value) {
+        if (swapping_) {
+            write_swapped(dst, &value);
+        } else {
+            memcpy(dst, &value, sizeof(uint32_t));
+        }
+    }
+
+    template <typename T>
+    static void write_swapped(uint8_t* dst, const T* value) {
+        const uint8_t* src = reinterpret_cast<const uint8_t*>(value);
+        for (size_t i = 0; i < sizeof(T); i++) {
+            dst[i] = src[sizeof(T) - 1 - i];
+        }
+    }
 };
 
 }
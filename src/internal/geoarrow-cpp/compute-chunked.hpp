@@ -0,0 +1,240 @@
+
+#pragma once
+
+#include <cstring>
+#include <deque>
+#include <memory>
+#include <string>
+
+#include "handler.hpp"
+#include "compute-builder.hpp"
+#include "compute-factory.hpp"
+
+namespace geoarrow {
+
+// Wraps the builder for a compute operation such that output is sealed into
+// a new chunk whenever the current chunk reaches "max_chunk_rows" features
+// or an estimated "max_chunk_bytes" bytes. Chunks are only sealed at a feature
+// boundary, so a single feature larger than "max_chunk_bytes" gets a chunk
+// of its own. Limits that are missing or <= 0 are not applied. Keeping
+// chunks small avoids large reallocations and means that binary output
+// never needs to be promoted to 64-bit offsets.
+class ChunkedBuilder: public Handler {
+public:
+    ChunkedBuilder(const std::string& op, const ComputeOptions& options):
+        op_(op), options_(options), sealed_any_(false), schema_(nullptr),
+        geometry_type_(util::GeometryType::GEOMETRY_TYPE_UNKNOWN),
+        dimensions_(util::Dimensions::DIMENSIONS_UNKNOWN), array_data_(nullptr),
+        chunk_rows_(0), chunk_bytes_(0) {
+        max_chunk_rows_ = options.get_int("max_chunk_rows", -1);
+        max_chunk_bytes_ = options.get_int("max_chunk_bytes", -1);
+        ordinate_bytes_ = ordinate_bytes(options);
+
+        new_chunk();
+    }
+
+    ~ChunkedBuilder() {
+        for (Chunk& chunk: chunks_) {
+            chunk.array_data.release(&chunk.array_data);
+            chunk.schema.release(&chunk.schema);
+        }
+    }
+
+    // True if options request chunked output
+    static bool is_chunked(const ComputeOptions& options) {
+        return options.get_int("max_chunk_rows", -1) > 0 ||
+            options.get_int("max_chunk_bytes", -1) > 0;
+    }
+
+    // Seals the current chunk after the last feature has been written. This
+    // always seals at least one chunk such that there is an output schema
+    // even if no features were written.
+    void finish() {
+        if (chunk_rows_ > 0 || !sealed_any_) {
+            seal_chunk();
+        }
+    }
+
+    // The number of sealed chunks that have not yet been released
+    int64_t num_chunks() { return chunks_.size(); }
+
+    // Moves the oldest sealed chunk to array_data and schema, returning
+    // false if there are no sealed chunks remaining
+    bool release_chunk(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+        if (chunks_.empty()) {
+            return false;
+        }
+
+        Chunk& chunk = chunks_.front();
+        memcpy(array_data, &chunk.array_data, sizeof(struct ArrowArray));
+        memcpy(schema, &chunk.schema, sizeof(struct ArrowSchema));
+        chunks_.pop_front();
+        return true;
+    }
+
+    void new_schema(const ArrowSchema* schema) {
+        schema_ = schema;
+        builder_->new_schema(schema);
+    }
+
+    void new_geometry_type(util::GeometryType geometry_type) {
+        geometry_type_ = geometry_type;
+        builder_->new_geometry_type(geometry_type);
+    }
+
+    void new_dimensions(util::Dimensions dimensions) {
+        dimensions_ = dimensions;
+        builder_->new_dimensions(dimensions);
+    }
+
+    Result array_start(const struct ArrowArray* array_data) {
+        array_data_ = array_data;
+        return builder_->array_start(array_data);
+    }
+
+    Result feat_start() {
+        if (chunk_full()) {
+            // The array that is being read continues in the next chunk
+            if (array_data_ != nullptr) {
+                builder_->array_end();
+            }
+
+            seal_chunk();
+            new_chunk();
+        }
+
+        chunk_rows_++;
+        chunk_bytes_ += sizeof(int32_t);
+        return builder_->feat_start();
+    }
+
+    Result null_feat() {
+        return builder_->null_feat();
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        chunk_bytes_ += sizeof(int32_t);
+        return builder_->geom_start(geometry_type, size);
+    }
+
+    Result ring_start(int32_t size) {
+        chunk_bytes_ += sizeof(int32_t);
+        return builder_->ring_start(size);
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        chunk_bytes_ += n * coord_size * ordinate_bytes_;
+        return builder_->coords(coord, n, coord_size);
+    }
+
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        chunk_bytes_ += n * coord_size * ordinate_bytes_;
+        return builder_->coords_separated(lanes, n, coord_size);
+    }
+
+    Result ring_end() {
+        return builder_->ring_end();
+    }
+
+    Result geom_end() {
+        return builder_->geom_end();
+    }
+
+    Result feat_end() {
+        return builder_->feat_end();
+    }
+
+    Result array_end() {
+        array_data_ = nullptr;
+        return builder_->array_end();
+    }
+
+private:
+    struct Chunk {
+        struct ArrowArray array_data;
+        struct ArrowSchema schema;
+    };
+
+    std::string op_;
+    ComputeOptions options_;
+    std::unique_ptr<ComputeBuilder> builder_;
+    std::deque<Chunk> chunks_;
+    bool sealed_any_;
+
+    const ArrowSchema* schema_;
+    util::GeometryType geometry_type_;
+    util::Dimensions dimensions_;
+    // The array being read (i.e., between array_start() and array_end())
+    const struct ArrowArray* array_data_;
+
+    int64_t max_chunk_rows_;
+    int64_t max_chunk_bytes_;
+    int64_t chunk_rows_;
+    // An estimate based on the size of the coordinates and offsets
+    // that have been written to the current chunk
+    int64_t chunk_bytes_;
+    // The size of one stored ordinate for the output storage type
+    int64_t ordinate_bytes_;
+
+    bool chunk_full() {
+        if (chunk_rows_ == 0) {
+            return false;
+        }
+
+        return (max_chunk_rows_ > 0 && chunk_rows_ >= max_chunk_rows_) ||
+            (max_chunk_bytes_ > 0 && chunk_bytes_ >= max_chunk_bytes_);
+    }
+
+    void new_chunk() {
+        builder_ = std::unique_ptr<ComputeBuilder>(create_builder(op_, options_));
+
+        // Replay the meta that was given to the previous builder
+        if (schema_ != nullptr) {
+            builder_->new_schema(schema_);
+            builder_->new_geometry_type(geometry_type_);
+            builder_->new_dimensions(dimensions_);
+        }
+
+        if (array_data_ != nullptr) {
+            builder_->array_start(array_data_);
+        }
+
+        chunk_rows_ = 0;
+        chunk_bytes_ = 0;
+    }
+
+    // Coordinates are stored as double unless the "schema" option requests
+    // float or (quantized) integer storage for a native geoarrow type
+    static int64_t ordinate_bytes(const ComputeOptions& options) {
+        util::StorageType storage_type;
+        try {
+            storage_type = Meta(options.get_schema("schema")).coord_storage_type_;
+        } catch (std::exception& e) {
+            return sizeof(double);
+        }
+
+        switch (storage_type) {
+        case util::StorageType::Float32:
+            return sizeof(float);
+        case util::StorageType::Int32:
+            return sizeof(int32_t);
+        case util::StorageType::Int16:
+            return sizeof(int16_t);
+        default:
+            return sizeof(double);
+        }
+    }
+
+    void seal_chunk() {
+        Chunk chunk;
+        chunk.array_data.release = nullptr;
+        chunk.schema.release = nullptr;
+        release_builder(builder_.get(), options_, &chunk.array_data, &chunk.schema);
+        chunks_.push_back(chunk);
+        sealed_any_ = true;
+        chunk_rows_ = 0;
+        chunk_bytes_ = 0;
+    }
+};
+
+}
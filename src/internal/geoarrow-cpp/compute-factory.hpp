@@ -10,8 +10,12 @@
 #include "compute-cast-linestring.hpp"
 #include "compute-cast-polygon.hpp"
 #include "compute-cast-collection.hpp"
+#include "compute-cast-geometry.hpp"
+#include "compute-cast-dictionary.hpp"
 #include "compute-bounds.hpp"
 #include "compute-geoparquet-types.hpp"
+#include "compute-feature-stats.hpp"
+#include "compute-feature-hash.hpp"
 
 namespace geoarrow {
 
@@ -23,7 +27,18 @@ ComputeBuilder* create_builder(const std::string& op, const ComputeOptions& opti
     if (op == "void") {
         return new NullBuilder();
     } else if (op == "cast") {
-        Meta geoarrow_meta(options.get_schema("schema"));
+        struct ArrowSchema* schema = options.get_schema("schema");
+
+        // A dictionary-encoded schema builds its dictionary using the
+        // builder for the dictionary's schema
+        if (schema->dictionary != nullptr) {
+            ComputeOptions values_options = options;
+            values_options.set_schema("schema", schema->dictionary);
+            std::unique_ptr<ComputeBuilder> values(create_builder(op, values_options));
+            return new DictionaryArrayBuilder(std::move(values), options);
+        }
+
+        Meta geoarrow_meta(schema);
 
         switch (geoarrow_meta.extension_) {
         case util::Extension::WKT:
@@ -42,6 +57,8 @@ ComputeBuilder* create_builder(const std::string& op, const ComputeOptions& opti
             return new MultiLinestringArrayBuilder(options);
         case util::Extension::MultiPolygon:
             return new MultiPolygonArrayBuilder(options);
+        case util::Extension::Geometry:
+            return new GeometryArrayBuilder(options);
         default:
             throw Meta::ValidationError("Unsupported extension type for operation CAST");
         }
@@ -49,6 +66,10 @@ ComputeBuilder* create_builder(const std::string& op, const ComputeOptions& opti
         return new GlobalBounder(options);
     } else if (op == "geoparquet_types") {
         return new GeoParquetTypeCollector(options);
+    } else if (op == "feature_stats") {
+        return new FeatureStatsBuilder(options);
+    } else if (op == "feature_hash") {
+        return new FeatureHashBuilder(options);
     } else {
         throw util::IOException("Unknown operation: '%s'", op.c_str());
     }
@@ -0,0 +1,336 @@
+
+#pragma once
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <vector>
+
+#include "handler.hpp"
+#include "compute-builder.hpp"
+#include "internal/arrow-hpp/builder.hpp"
+
+namespace geoarrow {
+
+namespace internal {
+
+// The bits of value after normalizing -0.0 to 0.0 and all NaNs to a single
+// NaN, such that coordinates that compare equal (or are both NaN) have
+// identical bits
+inline uint64_t normalized_bits(double value) {
+    if (value == 0) {
+        value = 0;
+    } else if (std::isnan(value)) {
+        value = std::numeric_limits<double>::quiet_NaN();
+    }
+
+    uint64_t bits;
+    memcpy(&bits, &value, sizeof(double));
+    return bits;
+}
+
+}
+
+// Computes a 64-bit hash of each feature's geometry types, nesting,
+// dimensions, and normalized coordinates. Sizes passed to geom_start() and ring_start()
+// are not part of the hash because they may be unknown (-1) for some
+// input types, and the hash doesn't depend on how coordinates are
+// batched into calls to coords(), so the same feature hashes the same
+// from any input type. Different features may (rarely) have the same hash.
+class FeatureHasher: public Handler {
+public:
+    FeatureHasher(): dimensions_(util::Dimensions::DIMENSIONS_UNKNOWN) { reset(); }
+
+    void reset() {
+        state_ = 14695981039346656037ULL;
+        coord_size_ = -1;
+        hashed_dimensions_ = util::Dimensions::DIMENSIONS_UNKNOWN;
+    }
+
+    // Readers only call new_dimensions() when the dimensions change, so these
+    // are kept between features (e.g., to tell POINT Z from POINT M)
+    void new_dimensions(util::Dimensions dimensions) {
+        dimensions_ = dimensions;
+    }
+
+    util::Dimensions dimensions() const { return dimensions_; }
+
+    // The hash of the features since the last call to reset()
+    uint64_t hash() const {
+        // splitmix64 finalizer so that all bits depend on all input
+        uint64_t z = state_;
+        z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+        z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+        return z ^ (z >> 31);
+    }
+
+    Result feat_start() {
+        reset();
+        return Result::CONTINUE;
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        add(EVENT_GEOM_START);
+        add(geometry_type);
+        return Result::CONTINUE;
+    }
+
+    Result ring_start(int32_t size) {
+        add(EVENT_RING_START);
+        return Result::CONTINUE;
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        if (coord_size != coord_size_ || dimensions_ != hashed_dimensions_) {
+            add(coord_size);
+            add(dimensions_);
+            coord_size_ = coord_size;
+            hashed_dimensions_ = dimensions_;
+        }
+
+        for (int64_t i = 0; i < (n * coord_size); i++) {
+            add(internal::normalized_bits(coord[i]));
+        }
+
+        return Result::CONTINUE;
+    }
+
+    Result ring_end() {
+        add(EVENT_RING_END);
+        return Result::CONTINUE;
+    }
+
+    Result geom_end() {
+        add(EVENT_GEOM_END);
+        return Result::CONTINUE;
+    }
+
+protected:
+    enum Event {
+        EVENT_GEOM_START = 1,
+        EVENT_RING_START = 2,
+        EVENT_COORDS = 3,
+        EVENT_RING_END = 4,
+        EVENT_GEOM_END = 5
+    };
+
+    util::Dimensions dimensions_;
+
+private:
+    uint64_t state_;
+    int32_t coord_size_;
+    util::Dimensions hashed_dimensions_;
+
+    // FNV-1a, one 64-bit word at a time
+    void add(uint64_t value) {
+        state_ = (state_ ^ value) * 1099511628211ULL;
+    }
+};
+
+// Records the events of a single feature such that it can be compared
+// to another feature and replayed into another handler (e.g., to write
+// only the first of several identical features).
+class FeatureRecorder: public FeatureHasher {
+public:
+    void reset() {
+        FeatureHasher::reset();
+        events_.clear();
+        coords_.clear();
+    }
+
+    Result feat_start() {
+        reset();
+        return Result::CONTINUE;
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        add_event(EVENT_GEOM_START, geometry_type, size);
+        return FeatureHasher::geom_start(geometry_type, size);
+    }
+
+    Result ring_start(int32_t size) {
+        add_event(EVENT_RING_START, 0, size);
+        return FeatureHasher::ring_start(size);
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        // Consecutive calls are merged such that equals() doesn't depend on
+        // how coordinates were batched
+        if (events_.empty() || events_.back().type != EVENT_COORDS ||
+                events_.back().size != coord_size ||
+                events_.back().dimensions != dimensions_) {
+            add_event(EVENT_COORDS, 0, coord_size);
+        }
+
+        events_.back().n_coords += n;
+        coords_.insert(coords_.end(), coord, coord + (n * coord_size));
+        return FeatureHasher::coords(coord, n, coord_size);
+    }
+
+    Result ring_end() {
+        add_event(EVENT_RING_END, 0, 0);
+        return FeatureHasher::ring_end();
+    }
+
+    Result geom_end() {
+        add_event(EVENT_GEOM_END, 0, 0);
+        return FeatureHasher::geom_end();
+    }
+
+    // True if other recorded the same geometry types, nesting, dimensions, and
+    // normalized coordinates (i.e., ignoring sizes passed to geom_start()
+    // and ring_start())
+    bool equals(const FeatureRecorder& other) const {
+        if (events_.size() != other.events_.size() ||
+                coords_.size() != other.coords_.size()) {
+            return false;
+        }
+
+        for (size_t i = 0; i < events_.size(); i++) {
+            const EventItem& a = events_[i];
+            const EventItem& b = other.events_[i];
+            if (a.type != b.type || a.geometry_type != b.geometry_type ||
+                    a.dimensions != b.dimensions || a.n_coords != b.n_coords ||
+                    (a.type == EVENT_COORDS && a.size != b.size)) {
+                return false;
+            }
+        }
+
+        for (size_t i = 0; i < coords_.size(); i++) {
+            if (internal::normalized_bits(coords_[i]) !=
+                    internal::normalized_bits(other.coords_[i])) {
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // Replays the recorded feature, including feat_start() and feat_end().
+    // new_dimensions() is replayed before any event whose dimensions differ
+    // from those of the previous event.
+    Result replay(Handler* handler) const {
+        Result result;
+        HANDLE_OR_RETURN(handler->feat_start());
+
+        const double* coord = coords_.data();
+        util::Dimensions dimensions = util::Dimensions::DIMENSIONS_UNKNOWN;
+        for (const EventItem& event: events_) {
+            if (event.dimensions != dimensions &&
+                    event.dimensions != util::Dimensions::DIMENSIONS_UNKNOWN) {
+                handler->new_dimensions(event.dimensions);
+                dimensions = event.dimensions;
+            }
+
+            switch (event.type) {
+            case EVENT_GEOM_START:
+                HANDLE_OR_RETURN(handler->geom_start(
+                    static_cast<util::GeometryType>(event.geometry_type), event.size));
+                break;
+            case EVENT_RING_START:
+                HANDLE_OR_RETURN(handler->ring_start(event.size));
+                break;
+            case EVENT_COORDS:
+                HANDLE_OR_RETURN(handler->coords(coord, event.n_coords, event.size));
+                coord += event.n_coords * event.size;
+                break;
+            case EVENT_RING_END:
+                HANDLE_OR_RETURN(handler->ring_end());
+                break;
+            case EVENT_GEOM_END:
+                HANDLE_OR_RETURN(handler->geom_end());
+                break;
+            }
+        }
+
+        return handler->feat_end();
+    }
+
+private:
+    struct EventItem {
+        Event type;
+        int32_t geometry_type;
+        // The size passed to geom_start()/ring_start() or the coord_size
+        // passed to coords()
+        int32_t size;
+        util::Dimensions dimensions;
+        int64_t n_coords;
+    };
+
+    std::vector<EventItem> events_;
+    std::vector<double> coords_;
+
+    void add_event(Event type, int32_t geometry_type, int32_t size) {
+        EventItem event;
+        event.type = type;
+        event.geometry_type = geometry_type;
+        event.size = size;
+        event.dimensions = dimensions_;
+        event.n_coords = 0;
+        events_.push_back(event);
+    }
+};
+
+// Computes FeatureHasher::hash() for each feature as an int64 array (i.e.,
+// the bits of the unsigned hash). Null features have a null hash. Features
+// with the same hash are almost always identical, which is the first step
+// in finding duplicates (e.g., to dictionary-encode an array).
+class FeatureHashBuilder: public ComputeBuilder {
+public:
+    FeatureHashBuilder(const ComputeOptions& options): ComputeBuilder(options) {}
+
+    void new_dimensions(util::Dimensions dimensions) {
+        hasher_.new_dimensions(dimensions);
+    }
+
+    Result feat_start() {
+        return hasher_.feat_start();
+    }
+
+    Result null_feat() {
+        builder_.write_null();
+        size_++;
+        return Result::ABORT_FEATURE;
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        return hasher_.geom_start(geometry_type, size);
+    }
+
+    Result ring_start(int32_t size) {
+        return hasher_.ring_start(size);
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        return hasher_.coords(coord, n, coord_size);
+    }
+
+    Result ring_end() {
+        return hasher_.ring_end();
+    }
+
+    Result geom_end() {
+        return hasher_.geom_end();
+    }
+
+    Result feat_end() {
+        uint64_t hash = hasher_.hash();
+        int64_t hash_signed;
+        memcpy(&hash_signed, &hash, sizeof(int64_t));
+        builder_.write_element(hash_signed);
+        size_++;
+        return Result::CONTINUE;
+    }
+
+    void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+        builder_.shrink();
+        builder_.release(array_data, schema);
+    }
+
+private:
+    FeatureHasher hasher_;
+    arrow::hpp::builder::Int64ArrayBuilder builder_;
+};
+
+}
@@ -0,0 +1,115 @@
+
+#pragma once
+
+#include <memory>
+
+#include "handler.hpp"
+#include "compute-builder.hpp"
+#include "compute-bounds.hpp"
+#include "internal/arrow-hpp/builder.hpp"
+#include "internal/arrow-hpp/builder-struct.hpp"
+
+namespace geoarrow {
+
+// Computes the xy bounds and the ISO WKB-style geometry type code
+// (geometry type + dimensions) of each feature in a single pass. This
+// is what a GeoParquet writer needs to populate row group-level statistics
+// without iterating over the input more than once. Null features have
+// NaN bounds and a geometry type code of 0; empty features have
+// bounds of Inf/-Inf.
+class FeatureStatsBuilder: public ComputeBuilder {
+public:
+    FeatureStatsBuilder(const ComputeOptions& options):
+        dim_(util::Dimensions::DIMENSIONS_UNKNOWN),
+        geometry_dim_(util::Dimensions::DIMENSIONS_UNKNOWN),
+        geometry_type_(util::GeometryType::GEOMETRY_TYPE_UNKNOWN),
+        level_(0) {
+        for (int i = 0; i < 4; i++) {
+            bounds_builders_[i] = std::unique_ptr<arrow::hpp::builder::Float64ArrayBuilder>(
+                new arrow::hpp::builder::Float64ArrayBuilder());
+        }
+
+        type_builder_ = std::unique_ptr<arrow::hpp::builder::Int32ArrayBuilder>(
+            new arrow::hpp::builder::Int32ArrayBuilder());
+    }
+
+    void new_dimensions(util::Dimensions dim) {
+        dim_ = dim;
+    }
+
+    Result feat_start() {
+        bounder_.reset(4);
+        geometry_type_ = util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
+        level_ = 0;
+        return Result::CONTINUE;
+    }
+
+    Result null_feat() {
+        bounder_.set_null();
+        geometry_type_ = util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
+        write_feature(0);
+        return Result::ABORT_FEATURE;
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        if (level_ == 0) {
+            geometry_type_ = geometry_type;
+            geometry_dim_ = dim_;
+        }
+
+        level_++;
+        return Result::CONTINUE;
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        bounder_.add_coords(coord, n, coord_size);
+        return Result::CONTINUE;
+    }
+
+    Result geom_end() {
+        level_--;
+        return Result::CONTINUE;
+    }
+
+    Result feat_end() {
+        int32_t type_code = geometry_type_;
+        if (geometry_dim_ != util::Dimensions::DIMENSIONS_UNKNOWN) {
+            type_code += geometry_dim_;
+        }
+
+        write_feature(type_code);
+        return Result::CONTINUE;
+    }
+
+    void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+        arrow::hpp::builder::StructArrayBuilder builder;
+        builder.add_child(std::move(bounds_builders_[0]), "xmin");
+        builder.add_child(std::move(bounds_builders_[1]), "ymin");
+        builder.add_child(std::move(bounds_builders_[2]), "xmax");
+        builder.add_child(std::move(bounds_builders_[3]), "ymax");
+        builder.add_child(std::move(type_builder_), "geometry_type");
+
+        builder.shrink();
+        builder.release(array_data, schema);
+    }
+
+private:
+    util::Dimensions dim_;
+    util::Dimensions geometry_dim_;
+    util::GeometryType geometry_type_;
+    int level_;
+    util::GenericBounder bounder_;
+    std::unique_ptr<arrow::hpp::builder::Float64ArrayBuilder> bounds_builders_[4];
+    std::unique_ptr<arrow::hpp::builder::Int32ArrayBuilder> type_builder_;
+
+    void write_feature(int32_t type_code) {
+        bounds_builders_[0]->write_element(bounder_.min_coord(0));
+        bounds_builders_[1]->write_element(bounder_.min_coord(1));
+        bounds_builders_[2]->write_element(bounder_.max_coord(0));
+        bounds_builders_[3]->write_element(bounder_.max_coord(1));
+        type_builder_->write_element(type_code);
+        size_++;
+    }
+};
+
+}
@@ -0,0 +1,270 @@
+
+#pragma once
+
+#include <cerrno>
+#include <memory>
+#include <string>
+
+#include "array-view-base.hpp"
+#include "compute-builder.hpp"
+#include "factory.hpp"
+#include "compute-factory.hpp"
+#include "compute-chunked.hpp"
+
+extern "C" int geoarrow_compute_stream_get_schema(struct ArrowArrayStream* stream,
+                                                  struct ArrowSchema* out);
+extern "C" int geoarrow_compute_stream_get_next(struct ArrowArrayStream* stream,
+                                                struct ArrowArray* out);
+extern "C" const char* geoarrow_compute_stream_get_last_error(struct ArrowArrayStream* stream);
+extern "C" void geoarrow_compute_stream_release(struct ArrowArrayStream* stream);
+
+namespace geoarrow {
+
+// Lazily applies a compute operation to each array of an input stream.
+// Each call to get_next() pulls exactly one array from the input, runs it
+// through a fresh builder, and releases the input array before returning,
+// so at most one input and one output array are held at any given time.
+// If options specify "max_chunk_rows" or "max_chunk_bytes", the output for
+// each input array may be split into more than one output array, in which
+// case the remaining output arrays for the current input are held until
+// they are requested.
+class ComputeStream {
+public:
+    // Takes ownership of input (i.e., input->release is set to nullptr)
+    ComputeStream(struct ArrowArrayStream* input, const std::string& op,
+                  const ComputeOptions& options):
+        op_(op), options_(options.deep_copy()) {
+        input_ = *input;
+        input->release = nullptr;
+        input_schema_.release = nullptr;
+        schema_.release = nullptr;
+        pending_.release = nullptr;
+
+        // The destructor doesn't run if the constructor throws
+        try {
+            if (input_.get_schema(&input_, &input_schema_) != 0) {
+                throw util::IOException(
+                    "input->get_schema() failed: %s", input_last_error());
+            }
+
+            view_ = std::unique_ptr<ArrayView>(create_view(&input_schema_));
+
+            // Validates op and options before any arrays are pulled
+            std::unique_ptr<ComputeBuilder> builder(create_builder(op_, options_));
+        } catch (std::exception& e) {
+            release_input();
+            throw;
+        }
+    }
+
+    ~ComputeStream() {
+        release_input();
+    }
+
+    // With strict = true, the output schema is that of a zero-length result.
+    // Otherwise the output type may depend on the data (e.g., the dimensions
+    // or offset width chosen by "cast"), so the schema is that of the first
+    // output array, which is computed here and held until get_next().
+    // Every array returned by get_next() must have this schema.
+    void get_schema(struct ArrowSchema* out) {
+        if (schema_.release == nullptr) {
+            if (!options_.get_bool("strict", false)) {
+                next_array(&pending_, &schema_);
+            }
+
+            // An empty stream (or strict = true)
+            if (schema_.release == nullptr) {
+                empty_schema(&schema_);
+            }
+        }
+
+        arrow::hpp::schema_deep_copy(&schema_, out);
+    }
+
+    void get_next(struct ArrowArray* out) {
+        if (pending_.release != nullptr) {
+            memcpy(out, &pending_, sizeof(struct ArrowArray));
+            pending_.release = nullptr;
+            return;
+        }
+
+        struct ArrowSchema schema_out;
+        schema_out.release = nullptr;
+        next_array(out, &schema_out);
+        if (out->release == nullptr) {
+            return;
+        }
+
+        if (schema_.release == nullptr) {
+            memcpy(&schema_, &schema_out, sizeof(struct ArrowSchema));
+            return;
+        }
+
+        bool identical = arrow::hpp::schema_format_identical(&schema_out, &schema_);
+        schema_out.release(&schema_out);
+        if (!identical) {
+            out->release(out);
+            throw util::IOException(
+                "Output array doesn't match the stream's schema (use strict = true)");
+        }
+    }
+
+    const char* last_error() {
+        return last_error_.c_str();
+    }
+
+    void set_last_error(const std::string& error) {
+        last_error_ = error;
+    }
+
+    // Transfers ownership of stream to out
+    static void export_stream(std::unique_ptr<ComputeStream> stream,
+                              struct ArrowArrayStream* out) {
+        out->get_schema = &geoarrow_compute_stream_get_schema;
+        out->get_next = &geoarrow_compute_stream_get_next;
+        out->get_last_error = &geoarrow_compute_stream_get_last_error;
+        out->release = &geoarrow_compute_stream_release;
+        out->private_data = stream.release();
+    }
+
+private:
+    struct ArrowArrayStream input_;
+    struct ArrowSchema input_schema_;
+    std::string op_;
+    ComputeOptions options_;
+    std::unique_ptr<ArrayView> view_;
+    std::unique_ptr<ChunkedBuilder> chunked_;
+    std::string last_error_;
+    // The output schema once it is known and an output array that was
+    // computed by get_schema() but not yet returned by get_next()
+    struct ArrowSchema schema_;
+    struct ArrowArray pending_;
+
+    void empty_schema(struct ArrowSchema* out) {
+        std::unique_ptr<ComputeBuilder> builder(create_builder(op_, options_));
+        view_->read_meta(builder.get());
+
+        struct ArrowArray array_data;
+        array_data.release = nullptr;
+        builder->release(&array_data, out);
+        array_data.release(&array_data);
+    }
+
+    // Computes the next output array and its schema (out->release is
+    // nullptr at the end of the stream)
+    void next_array(struct ArrowArray* out, struct ArrowSchema* schema_out) {
+        // Chunks left over from the last input array
+        if (chunked_ && chunked_->release_chunk(out, schema_out)) {
+            return;
+        }
+
+        struct ArrowArray array_in;
+        array_in.release = nullptr;
+        if (input_.get_next(&input_, &array_in) != 0) {
+            throw util::IOException("input->get_next() failed: %s", input_last_error());
+        }
+
+        // End of stream
+        if (array_in.release == nullptr) {
+            out->release = nullptr;
+            return;
+        }
+
+        struct ArrowSchema schema_tmp;
+        schema_tmp.release = nullptr;
+
+        try {
+            if (ChunkedBuilder::is_chunked(options_)) {
+                chunked_ = std::unique_ptr<ChunkedBuilder>(new ChunkedBuilder(op_, options_));
+                view_->read_meta(chunked_.get());
+                view_->set_array(&array_in);
+                view_->read_features(chunked_.get());
+                chunked_->finish();
+                chunked_->release_chunk(out, &schema_tmp);
+            } else {
+                std::unique_ptr<ComputeBuilder> builder(create_builder(op_, options_));
+                view_->read_meta(builder.get());
+                view_->set_array(&array_in);
+                builder->read_view(view_.get());
+                release_builder(builder.get(), options_, out, &schema_tmp);
+            }
+        } catch (std::exception& e) {
+            array_in.release(&array_in);
+            throw;
+        }
+
+        array_in.release(&array_in);
+        memcpy(schema_out, &schema_tmp, sizeof(struct ArrowSchema));
+    }
+
+    void release_input() {
+        if (pending_.release != nullptr) {
+            pending_.release(&pending_);
+        }
+
+        if (schema_.release != nullptr) {
+            schema_.release(&schema_);
+        }
+
+        if (input_schema_.release != nullptr) {
+            input_schema_.release(&input_schema_);
+        }
+
+        if (input_.release != nullptr) {
+            input_.release(&input_);
+        }
+    }
+
+    const char* input_last_error() {
+        const char* error = input_.get_last_error(&input_);
+        return error == nullptr ? "<unknown error>" : error;
+    }
+};
+
+}
+
+#if defined(ARROW_HPP_IMPL)
+
+int geoarrow_compute_stream_get_schema(struct ArrowArrayStream* stream,
+                                       struct ArrowSchema* out) {
+    auto private_data = reinterpret_cast<geoarrow::ComputeStream*>(stream->private_data);
+
+    try {
+        out->release = nullptr;
+        private_data->get_schema(out);
+        return 0;
+    } catch (std::exception& e) {
+        private_data->set_last_error(e.what());
+        return EINVAL;
+    }
+}
+
+int geoarrow_compute_stream_get_next(struct ArrowArrayStream* stream,
+                                     struct ArrowArray* out) {
+    auto private_data = reinterpret_cast<geoarrow::ComputeStream*>(stream->private_data);
+
+    try {
+        out->release = nullptr;
+        private_data->get_next(out);
+        return 0;
+    } catch (std::exception& e) {
+        private_data->set_last_error(e.what());
+        return EINVAL;
+    }
+}
+
+const char* geoarrow_compute_stream_get_last_error(struct ArrowArrayStream* stream) {
+    auto private_data = reinterpret_cast<geoarrow::ComputeStream*>(stream->private_data);
+    return private_data->last_error();
+}
+
+void geoarrow_compute_stream_release(struct ArrowArrayStream* stream) {
+    if (stream == nullptr || stream->release == nullptr) {
+        return;
+    }
+
+    delete reinterpret_cast<geoarrow::ComputeStream*>(stream->private_data);
+    stream->release = nullptr;
+}
+
+#endif
@@ -4,6 +4,7 @@
 #include "array-view-geoarrow.hpp"
 #include "array-view-wkb.hpp"
 #include "array-view-wkt.hpp"
+#include "array-view-dictionary.hpp"
 
 namespace geoarrow {
 
@@ -62,6 +63,12 @@ ArrayView* create_view_wkt(struct ArrowSchema* schema, Meta& geoarrow_meta) {
 } // anonymous namespace
 
 ArrayView* create_view(struct ArrowSchema* schema) {
+    // dictionary-encoded arrays are read through a view of their dictionary
+    if (schema->dictionary != nullptr) {
+        std::unique_ptr<ArrayView> values(create_view(schema->dictionary));
+        return new DictionaryArrayView(schema, std::move(values));
+    }
+
     // parse the schema and check that the structure is not unexpected
     // (e.g., the extension type and storage type are compatible and
     // there are not an unexpected number of children)
@@ -83,6 +90,9 @@ ArrayView* create_view(struct ArrowSchema* schema) {
     case util::Extension::GeometryCollection:
         return create_view_collection(schema, geoarrow_meta);
 
+    case util::Extension::Geometry:
+        return new GeometryArrayView(schema);
+
     case util::Extension::WKB:
         return create_view_wkb(schema, geoarrow_meta);
 
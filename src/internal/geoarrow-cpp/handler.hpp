@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <algorithm>
 #include <cstdint>
 #include "common.hpp"
 
@@ -30,12 +31,58 @@ public:
     virtual Result geom_start(util::GeometryType geometry_type, int32_t size) { return Result::CONTINUE; }
     virtual Result ring_start(int32_t size) { return Result::CONTINUE; }
     virtual Result coords(const double* coord, int64_t n, int32_t coord_size) { return Result::CONTINUE; }
+
+    // Called instead of coords() for coordinates stored as one array per
+    // dimension (i.e., lanes[j][i] is dimension j of coordinate i). Handlers
+    // that can use separate lanes directly should override this; the default
+    // interleaves coordinates in fixed-size batches and calls coords().
+    virtual Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        // The common coord_sizes are dispatched to a compile-time constant so
+        // that the loop over dimensions can be unrolled
+        switch (coord_size) {
+        case 2:
+            return interleave_coords<2>(lanes, n, coord_size);
+        case 3:
+            return interleave_coords<3>(lanes, n, coord_size);
+        case 4:
+            return interleave_coords<4>(lanes, n, coord_size);
+        default:
+            return interleave_coords<0>(lanes, n, coord_size);
+        }
+    }
+
     virtual Result ring_end() { return Result::CONTINUE; }
     virtual Result geom_end() { return Result::CONTINUE; }
     virtual Result feat_end() { return Result::CONTINUE; }
     virtual Result array_end() { return Result::CONTINUE; }
 
     virtual ~Handler() {}
+
+private:
+    // CoordSize is 0 if coord_size is not known at compile time
+    template <int CoordSize>
+    Result interleave_coords(const double* const* lanes, int64_t n, int32_t coord_size) {
+        const int32_t size = CoordSize == 0 ? coord_size : CoordSize;
+        const int64_t batch_size = 64;
+        double coord[batch_size * 4];
+        Result result;
+
+        for (int64_t offset = 0; offset < n; offset += batch_size) {
+            int64_t batch_n = std::min<int64_t>(batch_size, n - offset);
+            for (int64_t i = 0; i < batch_n; i++) {
+                for (int32_t j = 0; j < size; j++) {
+                    coord[i * size + j] = lanes[j][offset + i];
+                }
+            }
+
+            result = coords(coord, batch_n, coord_size);
+            if (result != Result::CONTINUE) {
+                return result;
+            }
+        }
+
+        return Result::CONTINUE;
+    }
 };
 
 }
@@ -0,0 +1,233 @@
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+// Opt-in counters for the hot paths (e.g., handler events, buffer
+// reallocations, byte swapping), enabled by compiling with
+// -DGEOARROW_INSTRUMENT. When disabled, GEOARROW_COUNT() expands to nothing
+// and the PhaseTimer and CountingHandler are no-ops such that instrumented
+// code doesn't need any #ifdefs. This header must be included before the
+// arrow-hpp builders (geoarrow.h does this) such that their hooks are defined.
+
+#if defined(GEOARROW_INSTRUMENT)
+
+#define GEOARROW_COUNT(counter, n) \
+    ::geoarrow::instrument::add(::geoarrow::instrument::Counter::counter, n)
+
+#define ARROW_HPP_ON_REALLOCATE(old_data, new_data, n_bytes_used)  \
+    do {                                                           \
+        GEOARROW_COUNT(BUFFER_REALLOCATIONS, 1);                   \
+        if ((old_data) != nullptr && (old_data) != (new_data)) {   \
+            GEOARROW_COUNT(BUFFER_BYTES_MOVED, n_bytes_used);      \
+        }                                                          \
+    } while (0)
+
+#define ARROW_HPP_ON_COPY(n_bytes) GEOARROW_COUNT(BUFFER_BYTES_COPIED, n_bytes)
+
+#else
+
+#define GEOARROW_COUNT(counter, n)
+
+#endif
+
+#include "handler.hpp"
+
+namespace geoarrow {
+
+namespace instrument {
+
+enum Counter {
+    FEAT_START,
+    NULL_FEAT,
+    GEOM_START,
+    RING_START,
+    COORDS,
+    COORDS_SEPARATED,
+    // The number of coordinates passed to coords() or coords_separated()
+    COORDS_N,
+    RING_END,
+    GEOM_END,
+    FEAT_END,
+    // Calls to realloc() by a BufferBuilder
+    BUFFER_REALLOCATIONS,
+    // Bytes copied by realloc() when a buffer had to be moved
+    BUFFER_BYTES_MOVED,
+    // Bytes copied into a BufferBuilder by write_buffer()
+    BUFFER_BYTES_COPIED,
+    // Values (sizes, geometry types, or ordinates) byte-swapped by the WKBReader
+    WKB_SWAPS,
+    // Errors reading WKB or WKT
+    PARSER_EXCEPTIONS,
+    // Views reused from (or created for lack of one in) the ViewPool
+    VIEW_POOL_HITS,
+    VIEW_POOL_MISSES,
+    // Wall time (in nanoseconds) spent in each phase of a compute operation
+    PHASE_OPTIONS_NS,
+    PHASE_CREATE_VIEW_NS,
+    PHASE_CREATE_BUILDER_NS,
+    PHASE_READ_NS,
+    PHASE_RELEASE_NS,
+    COUNTER_COUNT
+};
+
+// Names for each Counter (phases are exported in seconds)
+static const char* const counter_names[] = {
+    "feat_start", "null_feat", "geom_start", "ring_start", "coords",
+    "coords_separated", "coords_n", "ring_end", "geom_end", "feat_end",
+    "buffer_reallocations", "buffer_bytes_moved", "buffer_bytes_copied",
+    "wkb_swaps", "parser_exceptions", "view_pool_hits", "view_pool_misses",
+    "compute_options_seconds", "compute_create_view_seconds",
+    "compute_create_builder_seconds", "compute_read_seconds",
+    "compute_release_seconds"
+};
+
+static_assert(sizeof(counter_names) / sizeof(counter_names[0]) == COUNTER_COUNT,
+              "counter_names must have one name per Counter");
+
+inline bool is_phase(Counter counter) {
+    return counter >= PHASE_OPTIONS_NS;
+}
+
+#if defined(GEOARROW_INSTRUMENT)
+
+inline constexpr bool enabled() { return true; }
+
+// All counters are process-wide and may be incremented from any thread
+std::atomic<int64_t>* counters();
+
+inline void add(Counter counter, int64_t n) {
+    counters()[counter].fetch_add(n, std::memory_order_relaxed);
+}
+
+inline int64_t get(Counter counter) {
+    return counters()[counter].load(std::memory_order_relaxed);
+}
+
+inline void reset() {
+    for (int i = 0; i < COUNTER_COUNT; i++) {
+        counters()[i].store(0, std::memory_order_relaxed);
+    }
+}
+
+// Adds the wall time since construction (or the last call to lap())
+// to a phase counter
+class PhaseTimer {
+public:
+    PhaseTimer(): start_(std::chrono::steady_clock::now()) {}
+
+    void lap(Counter phase) {
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        add(phase, std::chrono::duration_cast<std::chrono::nanoseconds>(now - start_).count());
+        start_ = now;
+    }
+
+private:
+    std::chrono::steady_clock::time_point start_;
+};
+
+#else
+
+inline constexpr bool enabled() { return false; }
+inline void add(Counter counter, int64_t n) {}
+inline int64_t get(Counter counter) { return 0; }
+inline void reset() {}
+
+class PhaseTimer {
+public:
+    void lap(Counter phase) {}
+};
+
+#endif
+
+// Counts the events passed to another handler. Views call handler methods
+// directly, so handler events are counted by wrapping the handler at the
+// point where events are generated (e.g., the builder in a compute
+// operation) rather than in every view.
+class CountingHandler: public Handler {
+public:
+    CountingHandler(Handler* handler): handler_(handler) {}
+
+    void new_schema(const ArrowSchema* schema) { handler_->new_schema(schema); }
+
+    void new_geometry_type(util::GeometryType geometry_type) {
+        handler_->new_geometry_type(geometry_type);
+    }
+
+    void new_dimensions(util::Dimensions dimensions) {
+        handler_->new_dimensions(dimensions);
+    }
+
+    Result array_start(const struct ArrowArray* array_data) {
+        return handler_->array_start(array_data);
+    }
+
+    Result feat_start() {
+        add(FEAT_START, 1);
+        return handler_->feat_start();
+    }
+
+    Result null_feat() {
+        add(NULL_FEAT, 1);
+        return handler_->null_feat();
+    }
+
+    Result geom_start(util::GeometryType geometry_type, int32_t size) {
+        add(GEOM_START, 1);
+        return handler_->geom_start(geometry_type, size);
+    }
+
+    Result ring_start(int32_t size) {
+        add(RING_START, 1);
+        return handler_->ring_start(size);
+    }
+
+    Result coords(const double* coord, int64_t n, int32_t coord_size) {
+        add(COORDS, 1);
+        add(COORDS_N, n);
+        return handler_->coords(coord, n, coord_size);
+    }
+
+    Result coords_separated(const double* const* lanes, int64_t n, int32_t coord_size) {
+        add(COORDS_SEPARATED, 1);
+        add(COORDS_N, n);
+        return handler_->coords_separated(lanes, n, coord_size);
+    }
+
+    Result ring_end() {
+        add(RING_END, 1);
+        return handler_->ring_end();
+    }
+
+    Result geom_end() {
+        add(GEOM_END, 1);
+        return handler_->geom_end();
+    }
+
+    Result feat_end() {
+        add(FEAT_END, 1);
+        return handler_->feat_end();
+    }
+
+    Result array_end() {
+        return handler_->array_end();
+    }
+
+private:
+    Handler* handler_;
+};
+
+}
+
+#if defined(GEOARROW_INSTRUMENT) && defined(ARROW_HPP_IMPL)
+
+std::atomic<int64_t>* instrument::counters() {
+    static std::atomic<int64_t> values[COUNTER_COUNT];
+    return values;
+}
+
+#endif
+
+}
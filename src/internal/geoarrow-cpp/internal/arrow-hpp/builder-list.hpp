@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <limits>
 #include <sstream>
 
 #include "builder.hpp"
@@ -77,30 +78,66 @@ private:
   char format_[128];
 };
 
+// Offsets are written as int32 ("+l") until the child has more than
+// INT32_MAX elements, at which point they are promoted to int64 ("+L")
 template <typename ChildBuilderT>
 class ListArrayBuilder: public ArrayBuilder {
 public:
-  ListArrayBuilder() {
+  // The int64 offsets are only allocated if make_large() is called
+  ListArrayBuilder(): is_large_(false), large_offset_buffer_builder_(0) {
     offset_buffer_builder_.write_element(0);
   }
 
   ChildBuilderT& child() { return child_builder_; }
 
   void finish_element(bool not_null = true) {
+    int64_t child_size = child_builder_.size();
+    if (!is_large_ && child_size > std::numeric_limits<int32_t>::max()) {
+      make_large();
+    }
+
     size_ += 1;
     validity_buffer_builder_.write_element(not_null);
-    offset_buffer_builder_.write_element(child_builder_.size());
+    if (is_large_) {
+      large_offset_buffer_builder_.write_element(child_size);
+    } else {
+      offset_buffer_builder_.write_element(static_cast<int32_t>(child_size));
+    }
   }
 
   void shrink() {
     ArrayBuilder::shrink();
     child_builder_.shrink();
-    offset_buffer_builder_.shrink();
+    if (is_large_) {
+      large_offset_buffer_builder_.shrink();
+    } else {
+      offset_buffer_builder_.shrink();
+    }
   }
 
   void reserve(int64_t additional_capacity) {
     ArrayBuilder::reserve(additional_capacity);
-    offset_buffer_builder_.reserve(additional_capacity);
+    if (is_large_) {
+      large_offset_buffer_builder_.reserve(additional_capacity);
+    } else {
+      offset_buffer_builder_.reserve(additional_capacity);
+    }
+  }
+
+  bool is_large() { return is_large_; }
+
+  void make_large() {
+    if (is_large_) {
+      return;
+    }
+
+    large_offset_buffer_builder_.reserve(offset_buffer_builder_.size());
+    for (int64_t i = 0; i < offset_buffer_builder_.size(); i++) {
+      large_offset_buffer_builder_.write_element(offset_buffer_builder_.data()[i]);
+    }
+
+    free(offset_buffer_builder_.release());
+    is_large_ = true;
   }
 
   void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
@@ -113,7 +150,11 @@ public:
     finalizer.array_data.length = size();
     finalizer.array_data.null_count = validity_buffer_builder_.null_count();
     finalizer.array_data.buffers[0] = validity_buffer_builder_.release();
-    finalizer.array_data.buffers[1] = offset_buffer_builder_.release();
+    if (is_large_) {
+      finalizer.array_data.buffers[1] = large_offset_buffer_builder_.release();
+    } else {
+      finalizer.array_data.buffers[1] = offset_buffer_builder_.release();
+    }
 
     child_builder_.release(
         finalizer.array_data.children[0],
@@ -123,11 +164,17 @@ public:
   }
 
   const char* get_format() {
+    if (is_large_) {
+      return "+L";
+    } else {
       return "+l";
+    }
   }
 
 protected:
+  bool is_large_;
   builder::BufferBuilder<int32_t> offset_buffer_builder_;
+  builder::BufferBuilder<int64_t> large_offset_buffer_builder_;
   ChildBuilderT child_builder_;
 };
 
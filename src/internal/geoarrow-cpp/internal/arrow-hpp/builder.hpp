@@ -1,15 +1,27 @@
 
 #pragma once
 
+#include <cmath>
 #include <cstdlib>
 #include <limits>
 #include <cstring>
 #include <algorithm>
 #include <string>
+#include <vector>
 
 #include "common.hpp"
 #include "schema.hpp"
 
+// Hooks for instrumentation (e.g., counting reallocations), which must be
+// defined before this header is included
+#ifndef ARROW_HPP_ON_REALLOCATE
+#define ARROW_HPP_ON_REALLOCATE(old_data, new_data, n_bytes_used)
+#endif
+
+#ifndef ARROW_HPP_ON_COPY
+#define ARROW_HPP_ON_COPY(n_bytes)
+#endif
+
 // The classes and functions in this file are all about building
 // struct ArrowArray and struct ArrowSchema objects. All memory
 // is allocated using malloc() or realloc() and freed using free().
@@ -200,11 +212,70 @@ private:
   SchemaFinalizer schema_finalizer_;
 };
 
+// Memory used by one or more BufferBuilders, for tuning reserve hints and
+// growth factors. The peak capacity and size are in bytes; the slack is the
+// part of the peak capacity that was allocated but never written.
+struct MemoryStats {
+  MemoryStats(): n_buffers(0), peak_capacity(0), size(0), growth_steps(0) {}
+
+  int64_t n_buffers;
+  int64_t peak_capacity;
+  int64_t size;
+  int64_t growth_steps;
+
+  int64_t slack() const { return peak_capacity - size; }
+
+  void add(const MemoryStats& other) {
+    n_buffers += other.n_buffers;
+    peak_capacity += other.peak_capacity;
+    size += other.size;
+    growth_steps += other.growth_steps;
+  }
+};
+
+// Collects the MemoryStats of every BufferBuilder released on this thread
+// while the scope is alive (e.g., all the buffers of an ArrayBuilder and its
+// children during release()). Scopes may be nested, in which case the
+// inner scope's stats are also added to the outer scope.
+class MemoryStatsScope {
+public:
+  MemoryStatsScope(): previous_(current()) {
+    current() = &stats_;
+  }
+
+  ~MemoryStatsScope() {
+    current() = previous_;
+    if (previous_ != nullptr) {
+      previous_->add(stats_);
+    }
+  }
+
+  const MemoryStats& stats() const { return stats_; }
+
+  static void record(const MemoryStats& stats) {
+    if (current() != nullptr) {
+      current()->add(stats);
+    }
+  }
+
+private:
+  MemoryStats stats_;
+  MemoryStats* previous_;
+
+  MemoryStatsScope(const MemoryStatsScope&);
+  MemoryStatsScope& operator=(const MemoryStatsScope&);
+
+  static MemoryStats*& current() {
+    static thread_local MemoryStats* scope_stats = nullptr;
+    return scope_stats;
+  }
+};
+
 template<typename BufferT>
 class BufferBuilder {
 public:
   BufferBuilder(int64_t capacity = 1024): data_(nullptr), capacity_(-1),
-    size_(0), growth_factor_(2) {
+    size_(0), growth_factor_(2), peak_capacity_(0), growth_steps_(0) {
     reallocate(capacity);
   }
 
@@ -221,6 +292,10 @@ public:
   void shrink() { reallocate(size_); }
 
   virtual BufferT* release() {
+    if (data_ != nullptr) {
+      MemoryStatsScope::record(memory_stats());
+    }
+
     BufferT* out = data_;
     data_ = nullptr;
     return out;
@@ -234,6 +309,7 @@ public:
       );
 
       reallocate(target_capacity);
+      growth_steps_++;
     }
   }
 
@@ -253,13 +329,16 @@ public:
         "Failed to allocate BufferBuilder::data_ of capacity %lld", capacity);
     }
 
+    ARROW_HPP_ON_REALLOCATE(data_, new_data, size_ * sizeof(BufferT));
     data_ = new_data;
     capacity_ = n_bytes / sizeof(BufferT);
+    peak_capacity_ = std::max<int64_t>(peak_capacity_, capacity_);
   }
 
   void write_buffer(const BufferT* buffer, int64_t size) {
     reserve(size);
     memcpy(data_ + size_, buffer, size * sizeof(BufferT));
+    ARROW_HPP_ON_COPY(size * sizeof(BufferT));
     advance(size);
   }
 
@@ -270,12 +349,25 @@ public:
   int64_t capacity() { return capacity_; }
   int64_t size() { return size_; }
   int64_t remaining_capacity() { return capacity_ - size_; }
+  int64_t peak_capacity() { return peak_capacity_; }
+  int64_t growth_steps() { return growth_steps_; }
+
+  MemoryStats memory_stats() {
+    MemoryStats stats;
+    stats.n_buffers = 1;
+    stats.peak_capacity = peak_capacity_ * sizeof(BufferT);
+    stats.size = size_ * sizeof(BufferT);
+    stats.growth_steps = growth_steps_;
+    return stats;
+  }
 
 protected:
   BufferT* data_;
   int64_t capacity_;
   int64_t size_;
   double growth_factor_;
+  int64_t peak_capacity_;
+  int64_t growth_steps_;
 };
 
 class BitmapBuilder {
@@ -313,7 +405,26 @@ public:
   }
 
   void write_elements(int64_t n, bool value) {
-    // Could be more efficient!
+    // Fill the current byte one bit at a time
+    while (n > 0 && buffer_size_ != 0) {
+      write_element(value);
+      n--;
+    }
+
+    // Whole bytes of valid elements are either skipped (if no null has been
+    // written yet) or written a byte at a time
+    if (value) {
+      int64_t n_bytes = n / 8;
+      if (allocated_) {
+        buffer_builder_.reserve(n_bytes);
+        memset(buffer_builder_.data_at_cursor(), 0xff, n_bytes);
+        buffer_builder_.advance(n_bytes);
+      }
+
+      size_ += n_bytes * 8;
+      n -= n_bytes * 8;
+    }
+
     for (int64_t i = 0; i < n; i++) {
       write_element(value);
     }
@@ -413,6 +524,14 @@ public:
     throw util::Exception("Not implemented");
   }
 
+  // Calls release() and returns the MemoryStats of every buffer it released
+  // (including those of any child builders)
+  MemoryStats release_with_stats(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+    MemoryStatsScope scope;
+    release(array_data, schema);
+    return scope.stats();
+  }
+
   virtual const char* get_format() { return ""; }
 
 protected:
@@ -444,12 +563,24 @@ public:
     size_++;
   }
 
-  void write_buffer(const double* buffer, int64_t n) {
+  void write_buffer(const BufferT* buffer, int64_t n) {
     buffer_builder_.write_buffer(buffer, n);
     size_+= n;
   }
 
+  // Validity is only written once the first null is written
+  void write_null() {
+    validity_buffer_builder_.write_elements(size_ - validity_buffer_builder_.size(), true);
+    validity_buffer_builder_.write_element(false);
+    buffer_builder_.write_element(BufferT());
+    size_++;
+  }
+
   void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+    if (validity_buffer_builder_.size() > 0) {
+      validity_buffer_builder_.write_elements(size_ - validity_buffer_builder_.size(), true);
+    }
+
     CArrayFinalizer finalizer;
     finalizer.allocate(2);
     finalizer.set_schema_format(get_format());
@@ -475,6 +606,317 @@ public:
   virtual const char* get_format() { return "g"; }
 };
 
+class Int32ArrayBuilder: public FixedSizeLayoutArrayBuilder<int32_t> {
+public:
+  virtual const char* get_format() { return "i"; }
+};
+
+class Int64ArrayBuilder: public FixedSizeLayoutArrayBuilder<int64_t> {
+public:
+  virtual const char* get_format() { return "l"; }
+};
+
+// A numeric array builder whose storage type is chosen at runtime. Values
+// are always written as doubles and are converted as they are written.
+// For integer storage, values are quantized (i.e., stored as
+// round((value - offset) / scale)); values that can't be represented
+// by the storage type after quantizing are an error. The scale and
+// offset may cycle with a period of up to 4 values (e.g., for interleaved
+// xyxyxy... values with a different scale for x and y).
+class NumericArrayBuilder: public ArrayBuilder {
+public:
+  enum Storage {
+    DOUBLE,
+    FLOAT,
+    INT32,
+    INT16
+  };
+
+  NumericArrayBuilder(): storage_(Storage::DOUBLE), period_(1) {
+    scale_[0] = 1;
+    offset_[0] = 0;
+  }
+
+  void set_storage(Storage storage, const double* scale = nullptr,
+                   const double* offset = nullptr, int period = 1) {
+    if (period < 1 || period > 4) {
+      throw util::Exception("NumericArrayBuilder period must be between 1 and 4");
+    }
+
+    for (int k = 0; k < period; k++) {
+      scale_[k] = scale == nullptr ? 1 : scale[k];
+      offset_[k] = offset == nullptr ? 0 : offset[k];
+      if (scale_[k] == 0) {
+        throw util::Exception("NumericArrayBuilder scale must be non-zero");
+      }
+    }
+
+    storage_ = storage;
+    period_ = period;
+  }
+
+  Storage storage() const { return storage_; }
+
+  bool is_integer() const {
+    return storage_ == Storage::INT32 || storage_ == Storage::INT16;
+  }
+
+  int64_t item_size() const {
+    switch (storage_) {
+    case Storage::FLOAT: return sizeof(float);
+    case Storage::INT32: return sizeof(int32_t);
+    case Storage::INT16: return sizeof(int16_t);
+    default: return sizeof(double);
+    }
+  }
+
+  void reserve(int64_t additional_capacity) {
+    ArrayBuilder::reserve(additional_capacity);
+    buffer_builder_.reserve(additional_capacity * item_size());
+  }
+
+  void shrink() {
+    ArrayBuilder::shrink();
+    buffer_builder_.shrink();
+  }
+
+  void write_buffer(const double* buffer, int64_t n) {
+    write_strided(buffer, n, 1);
+  }
+
+  // Writes buffer[0], buffer[stride], ..., buffer[(n - 1) * stride]
+  void write_strided(const double* buffer, int64_t n, int64_t stride) {
+    switch (storage_) {
+    case Storage::FLOAT:
+      write_floating<float>(buffer, n, stride);
+      break;
+    case Storage::INT32:
+      write_integer<int32_t>(buffer, n, stride);
+      break;
+    case Storage::INT16:
+      write_integer<int16_t>(buffer, n, stride);
+      break;
+    default:
+      write_floating<double>(buffer, n, stride);
+      break;
+    }
+  }
+
+  // Writes lanes[0][0], lanes[1][0], ..., lanes[0][1], lanes[1][1], ...
+  // (i.e., the coordinates of n points whose dimensions are stored as
+  // n_lanes separate arrays)
+  void write_interleaved(const double* const* lanes, int64_t n, int n_lanes) {
+    switch (storage_) {
+    case Storage::DOUBLE:
+      write_interleaved_floating<double>(lanes, n, n_lanes);
+      break;
+    case Storage::FLOAT:
+      write_interleaved_floating<float>(lanes, n, n_lanes);
+      break;
+    default:
+      write_interleaved_batched(lanes, n, n_lanes);
+      break;
+    }
+  }
+
+  // Writes values[0], values[n_lanes], ... to lanes[0], values[1],
+  // values[n_lanes + 1], ... to lanes[1], and so on (i.e., the inverse of
+  // write_interleaved() for n points whose dimensions are stored together)
+  static void write_deinterleaved(NumericArrayBuilder* lanes, const double* values,
+                                  int64_t n, int n_lanes) {
+    for (int j = 0; j < n_lanes; j++) {
+      if (lanes[j].storage_ != Storage::DOUBLE) {
+        for (int k = 0; k < n_lanes; k++) {
+          lanes[k].write_strided(values + k, n, n_lanes);
+        }
+
+        return;
+      }
+    }
+
+    switch (n_lanes) {
+    case 2:
+      write_deinterleaved_double<2>(lanes, values, n, n_lanes);
+      break;
+    case 3:
+      write_deinterleaved_double<3>(lanes, values, n, n_lanes);
+      break;
+    case 4:
+      write_deinterleaved_double<4>(lanes, values, n, n_lanes);
+      break;
+    default:
+      write_deinterleaved_double<0>(lanes, values, n, n_lanes);
+      break;
+    }
+  }
+
+  // Writes n placeholder values (e.g., for null elements): NaN for
+  // floating-point storage or zero for integer storage
+  void write_empty(int64_t n) {
+    buffer_builder_.reserve(n * item_size());
+    if (is_integer()) {
+      memset(buffer_builder_.data_at_cursor(), 0, n * item_size());
+      buffer_builder_.advance(n * item_size());
+      size_ += n;
+    } else {
+      double nan_value = std::numeric_limits<double>::quiet_NaN();
+      write_strided(&nan_value, n, 0);
+    }
+  }
+
+  void release(struct ArrowArray* array_data, struct ArrowSchema* schema) {
+    CArrayFinalizer finalizer;
+    finalizer.allocate(2);
+    finalizer.set_schema_format(get_format());
+    finalizer.set_schema_name(name().c_str());
+    finalizer.set_schema_metadata(metadata_names_, metadata_values_);
+
+    finalizer.array_data.length = size();
+    finalizer.array_data.null_count = validity_buffer_builder_.null_count();
+
+    finalizer.array_data.buffers[0] = validity_buffer_builder_.release();
+    finalizer.array_data.buffers[1] = buffer_builder_.release();
+
+    finalizer.release(array_data, schema);
+  }
+
+  const char* get_format() {
+    switch (storage_) {
+    case Storage::FLOAT: return "f";
+    case Storage::INT32: return "i";
+    case Storage::INT16: return "s";
+    default: return "g";
+    }
+  }
+
+private:
+  BufferBuilder<uint8_t> buffer_builder_;
+  Storage storage_;
+  double scale_[4];
+  double offset_[4];
+  int period_;
+
+  template <typename T>
+  void write_floating(const double* buffer, int64_t n, int64_t stride) {
+    buffer_builder_.reserve(n * sizeof(T));
+    T* out = reinterpret_cast<T*>(buffer_builder_.data_at_cursor());
+    for (int64_t i = 0; i < n; i++) {
+      out[i] = static_cast<T>(buffer[i * stride]);
+    }
+
+    buffer_builder_.advance(n * sizeof(T));
+    size_ += n;
+  }
+
+  template <typename T>
+  void write_interleaved_floating(const double* const* lanes, int64_t n, int n_lanes) {
+    // The common lane counts are dispatched to a compile-time constant so
+    // that the inner loop is unrolled and the compiler can vectorize the
+    // transpose
+    switch (n_lanes) {
+    case 2:
+      write_interleaved_floating<T, 2>(lanes, n, n_lanes);
+      break;
+    case 3:
+      write_interleaved_floating<T, 3>(lanes, n, n_lanes);
+      break;
+    case 4:
+      write_interleaved_floating<T, 4>(lanes, n, n_lanes);
+      break;
+    default:
+      write_interleaved_floating<T, 0>(lanes, n, n_lanes);
+      break;
+    }
+  }
+
+  // NLanes is 0 if n_lanes is not known at compile time
+  template <typename T, int NLanes>
+  void write_interleaved_floating(const double* const* lanes, int64_t n, int n_lanes) {
+    const int size = NLanes == 0 ? n_lanes : NLanes;
+    buffer_builder_.reserve(n * size * sizeof(T));
+    T* out = reinterpret_cast<T*>(buffer_builder_.data_at_cursor());
+
+    for (int j = 0; j < size; j++) {
+      const double* lane = lanes[j];
+      T* out_lane = out + j;
+      for (int64_t i = 0; i < n; i++) {
+        out_lane[i * size] = static_cast<T>(lane[i]);
+      }
+    }
+
+    buffer_builder_.advance(n * size * sizeof(T));
+    size_ += n * size;
+  }
+
+  // Reads each point once and writes one value to every lane, which (with
+  // NLanes known at compile time) the compiler can vectorize as a transpose
+  template <int NLanes>
+  static void write_deinterleaved_double(NumericArrayBuilder* lanes, const double* values,
+                                         int64_t n, int n_lanes) {
+    const int size = NLanes == 0 ? n_lanes : NLanes;
+    double* out[4];
+    for (int j = 0; j < size; j++) {
+      lanes[j].buffer_builder_.reserve(n * sizeof(double));
+      out[j] = reinterpret_cast<double*>(lanes[j].buffer_builder_.data_at_cursor());
+    }
+
+    for (int64_t i = 0; i < n; i++) {
+      for (int j = 0; j < size; j++) {
+        out[j][i] = values[i * size + j];
+      }
+    }
+
+    for (int j = 0; j < size; j++) {
+      lanes[j].buffer_builder_.advance(n * sizeof(double));
+      lanes[j].size_ += n;
+    }
+  }
+
+  // Integer storage quantizes each value with the scale and offset of its
+  // dimension, which write_integer() tracks for interleaved values
+  void write_interleaved_batched(const double* const* lanes, int64_t n, int n_lanes) {
+    const int64_t batch_size = 64;
+    double batch[batch_size * 4];
+
+    for (int64_t offset = 0; offset < n; offset += batch_size) {
+      int64_t batch_n = std::min<int64_t>(batch_size, n - offset);
+      for (int64_t i = 0; i < batch_n; i++) {
+        for (int j = 0; j < n_lanes; j++) {
+          batch[i * n_lanes + j] = lanes[j][offset + i];
+        }
+      }
+
+      write_strided(batch, batch_n * n_lanes, 1);
+    }
+  }
+
+  template <typename T>
+  void write_integer(const double* buffer, int64_t n, int64_t stride) {
+    const double min_value = std::numeric_limits<T>::min();
+    const double max_value = std::numeric_limits<T>::max();
+
+    buffer_builder_.reserve(n * sizeof(T));
+    T* out = reinterpret_cast<T*>(buffer_builder_.data_at_cursor());
+    int k = size_ % period_;
+    for (int64_t i = 0; i < n; i++) {
+      double value = buffer[i * stride];
+      double quantized = std::round((value - offset_[k]) / scale_[k]);
+
+      // also false for NaN
+      if (!(quantized >= min_value && quantized <= max_value)) {
+        throw util::Exception(
+          "Can't store value %g as %d-bit integer with scale %g and offset %g",
+          value, static_cast<int>(sizeof(T) * 8), scale_[k], offset_[k]);
+      }
+
+      out[i] = static_cast<T>(quantized);
+      k = (k + 1) == period_ ? 0 : k + 1;
+    }
+
+    buffer_builder_.advance(n * sizeof(T));
+    size_ += n;
+  }
+};
 }
 
 }
@@ -0,0 +1,137 @@
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "common.hpp"
+
+// Constants from the Arrow IPC flatbuffer definitions (Schema.fbs, Message.fbs,
+// and File.fbs in the Arrow repository) that are needed to read and write
+// the IPC stream and file formats without depending on the flatbuffers
+// library. Field indices refer to the order of fields in each table
+// definition.
+
+namespace arrow {
+
+namespace hpp {
+
+namespace ipc {
+
+static const int32_t kContinuation = -1;
+static const char kFileMagic[] = "ARROW1";
+static const int64_t kFileMagicSize = 6;
+
+enum MetadataVersion {
+  V1 = 0,
+  V2 = 1,
+  V3 = 2,
+  V4 = 3,
+  V5 = 4
+};
+
+enum MessageHeader {
+  HEADER_NONE = 0,
+  HEADER_SCHEMA = 1,
+  HEADER_DICTIONARY_BATCH = 2,
+  HEADER_RECORD_BATCH = 3
+};
+
+enum Type {
+  TYPE_NONE = 0,
+  TYPE_NULL = 1,
+  TYPE_INT = 2,
+  TYPE_FLOATING_POINT = 3,
+  TYPE_BINARY = 4,
+  TYPE_UTF8 = 5,
+  TYPE_BOOL = 6,
+  TYPE_DECIMAL = 7,
+  TYPE_DATE = 8,
+  TYPE_TIME = 9,
+  TYPE_TIMESTAMP = 10,
+  TYPE_INTERVAL = 11,
+  TYPE_LIST = 12,
+  TYPE_STRUCT = 13,
+  TYPE_UNION = 14,
+  TYPE_FIXED_SIZE_BINARY = 15,
+  TYPE_FIXED_SIZE_LIST = 16,
+  TYPE_MAP = 17,
+  TYPE_DURATION = 18,
+  TYPE_LARGE_BINARY = 19,
+  TYPE_LARGE_UTF8 = 20,
+  TYPE_LARGE_LIST = 21
+};
+
+// Field indices for tables that are read or written
+namespace field {
+  enum Footer { FOOTER_VERSION = 0, FOOTER_SCHEMA = 1, FOOTER_DICTIONARIES = 2,
+                FOOTER_RECORD_BATCHES = 3 };
+  enum Message { MESSAGE_VERSION = 0, MESSAGE_HEADER_TYPE = 1, MESSAGE_HEADER = 2,
+                 MESSAGE_BODY_LENGTH = 3 };
+  enum Schema { SCHEMA_ENDIANNESS = 0, SCHEMA_FIELDS = 1, SCHEMA_METADATA = 2 };
+  enum Field { FIELD_NAME = 0, FIELD_NULLABLE = 1, FIELD_TYPE_TYPE = 2, FIELD_TYPE = 3,
+               FIELD_DICTIONARY = 4, FIELD_CHILDREN = 5, FIELD_METADATA = 6 };
+  enum KeyValue { KEY_VALUE_KEY = 0, KEY_VALUE_VALUE = 1 };
+  enum RecordBatch { RECORD_BATCH_LENGTH = 0, RECORD_BATCH_NODES = 1,
+                     RECORD_BATCH_BUFFERS = 2, RECORD_BATCH_COMPRESSION = 3 };
+}
+
+// The number of buffers for an array with a given format string. This is
+// the same for the C data interface and the IPC format (i.e., unions
+// and null arrays have no validity buffer).
+static inline int64_t format_n_buffers(const std::string& format) {
+  if (format == "n") {
+    return 0;
+  } else if (format == "z" || format == "Z" || format == "u" || format == "U") {
+    return 3;
+  } else if (format == "+l" || format == "+L" || format == "+m") {
+    return 2;
+  } else if (format.substr(0, 3) == "+ud") {
+    return 2;
+  } else if (format.substr(0, 3) == "+us" || format == "+s" ||
+             format.substr(0, 3) == "+w:") {
+    return 1;
+  } else {
+    return 2;
+  }
+}
+
+namespace internal {
+
+// The location of a record batch message in an IPC file
+struct Block {
+  int64_t offset;
+  int32_t metadata_length;
+  int64_t body_length;
+};
+
+// The parts of an ArrowSchema that are serialized to or from an IPC Schema
+struct FieldInfo {
+  std::string name;
+  std::string format;
+  int64_t flags;
+  std::vector<std::string> metadata_names;
+  std::vector<std::string> metadata_values;
+  std::vector<FieldInfo> children;
+};
+
+}
+
+static inline int64_t padded_size(int64_t size, int64_t alignment = 8) {
+  return (size + alignment - 1) / alignment * alignment;
+}
+
+static inline bool host_is_little_endian() {
+  uint32_t value = 1;
+  uint8_t first_byte;
+  memcpy(&first_byte, &value, 1);
+  return first_byte == 1;
+}
+
+}
+
+}
+
+}
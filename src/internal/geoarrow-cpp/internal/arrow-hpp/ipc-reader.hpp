@@ -0,0 +1,904 @@
+
+#pragma once
+
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <stdio.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "schema.hpp"
+#include "ipc-common.hpp"
+
+// A reader for uncompressed Arrow IPC files (i.e., Feather version 2) and
+// IPC streams. The file is memory-mapped and the struct ArrowArrays
+// exported here point directly into the mapping: no buffer is copied.
+// Each struct ArrowArray keeps a reference to the mapping, so arrays
+// stay valid after the Reader (or the stream exported from it) is gone.
+// Dictionary-encoded fields and compressed record batch bodies are not
+// supported. On Windows, the file is read into memory instead of mapped.
+
+extern "C" void arrow_hpp_ipc_release_array_internal(struct ArrowArray* array_data);
+extern "C" int arrow_hpp_ipc_stream_get_schema(struct ArrowArrayStream* stream,
+                                               struct ArrowSchema* out);
+extern "C" int arrow_hpp_ipc_stream_get_next(struct ArrowArrayStream* stream,
+                                             struct ArrowArray* out);
+extern "C" const char* arrow_hpp_ipc_stream_get_last_error(struct ArrowArrayStream* stream);
+extern "C" void arrow_hpp_ipc_stream_release(struct ArrowArrayStream* stream);
+
+namespace arrow {
+
+namespace hpp {
+
+namespace ipc {
+
+class MappedFile {
+public:
+  MappedFile(): data_(nullptr), size_(0) {}
+
+  ~MappedFile() {
+    if (data_ == nullptr) {
+      return;
+    }
+
+#if defined(_WIN32)
+    free(data_);
+#else
+    munmap(data_, size_);
+#endif
+  }
+
+  void open(const std::string& path) {
+#if defined(_WIN32)
+    FILE* f = fopen(path.c_str(), "rb");
+    if (f == nullptr) {
+      throw util::Exception("Failed to open '%s'", path.c_str());
+    }
+
+    fseek(f, 0, SEEK_END);
+    size_ = ftell(f);
+    fseek(f, 0, SEEK_SET);
+
+    data_ = reinterpret_cast<uint8_t*>(malloc(size_ > 0 ? size_ : 1));
+    if (data_ == nullptr) {
+      fclose(f);
+      throw util::Exception("Failed to allocate %lld bytes", (long long) size_);
+    }
+
+    int64_t bytes_read = fread(data_, 1, size_, f);
+    fclose(f);
+    if (bytes_read != size_) {
+      throw util::Exception("Failed to read '%s'", path.c_str());
+    }
+#else
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      throw util::Exception("Failed to open '%s'", path.c_str());
+    }
+
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+      close(fd);
+      throw util::Exception("Failed to stat '%s'", path.c_str());
+    }
+
+    size_ = st.st_size;
+    if (size_ == 0) {
+      close(fd);
+      throw util::Exception("Can't read zero-length file '%s'", path.c_str());
+    }
+
+    void* data = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED) {
+      throw util::Exception("Failed to mmap '%s'", path.c_str());
+    }
+
+    data_ = reinterpret_cast<uint8_t*>(data);
+#endif
+  }
+
+  const uint8_t* data() const { return data_; }
+  int64_t size() const { return size_; }
+
+private:
+  uint8_t* data_;
+  int64_t size_;
+};
+
+namespace internal {
+
+// Minimal read-only access to flatbuffer tables with bounds checking. Offsets
+// are relative to the start of the buffer pointed to by base_.
+class FlatbufferTable {
+public:
+  FlatbufferTable(): base_(nullptr), size_(0), pos_(-1), vtable_pos_(0), vtable_size_(0) {}
+
+  FlatbufferTable(const uint8_t* base, int64_t size, int64_t pos):
+      base_(base), size_(size), pos_(pos) {
+    int32_t vtable_offset = read<int32_t>(pos_);
+    vtable_pos_ = pos_ - vtable_offset;
+    vtable_size_ = read<uint16_t>(vtable_pos_);
+  }
+
+  static FlatbufferTable root(const uint8_t* base, int64_t size) {
+    FlatbufferTable dummy(base, size);
+    return FlatbufferTable(base, size, dummy.read<uint32_t>(0));
+  }
+
+  bool is_null() const { return pos_ < 0; }
+
+  bool has(int field) const {
+    return field_offset(field) != 0;
+  }
+
+  template <typename T>
+  T scalar(int field, T default_value) const {
+    uint16_t offset = field_offset(field);
+    if (offset == 0) {
+      return default_value;
+    } else {
+      return read<T>(pos_ + offset);
+    }
+  }
+
+  FlatbufferTable table(int field) const {
+    int64_t pos = indirect(field);
+    if (pos < 0) {
+      return FlatbufferTable();
+    } else {
+      return FlatbufferTable(base_, size_, pos);
+    }
+  }
+
+  std::string string(int field, const std::string& default_value = "") const {
+    int64_t pos = indirect(field);
+    if (pos < 0) {
+      return default_value;
+    }
+
+    uint32_t length = read<uint32_t>(pos);
+    check(pos + 4, length);
+    return std::string(reinterpret_cast<const char*>(base_ + pos + 4), length);
+  }
+
+  // Returns the number of elements in a vector field and sets *pos to the
+  // position of the first element
+  int64_t vector(int field, int64_t* pos) const {
+    int64_t vector_pos = indirect(field);
+    if (vector_pos < 0) {
+      *pos = -1;
+      return 0;
+    }
+
+    *pos = vector_pos + 4;
+    return read<uint32_t>(vector_pos);
+  }
+
+  FlatbufferTable vector_table(int64_t vector_pos, int64_t i) const {
+    int64_t element_pos = vector_pos + i * 4;
+    return FlatbufferTable(base_, size_, element_pos + read<uint32_t>(element_pos));
+  }
+
+  template <typename T>
+  T read(int64_t pos) const {
+    check(pos, sizeof(T));
+    T value;
+    memcpy(&value, base_ + pos, sizeof(T));
+    return value;
+  }
+
+  void check(int64_t pos, int64_t n) const {
+    if (pos < 0 || n < 0 || (pos + n) > size_) {
+      throw util::Exception(
+        "Invalid IPC flatbuffer: attempt to read %lld bytes at %lld (size %lld)",
+        (long long) n, (long long) pos, (long long) size_);
+    }
+  }
+
+private:
+  const uint8_t* base_;
+  int64_t size_;
+  int64_t pos_;
+  int64_t vtable_pos_;
+  uint16_t vtable_size_;
+
+  FlatbufferTable(const uint8_t* base, int64_t size):
+    base_(base), size_(size), pos_(0), vtable_pos_(0), vtable_size_(0) {}
+
+  uint16_t field_offset(int field) const {
+    if (pos_ < 0) {
+      return 0;
+    }
+
+    int64_t entry = 4 + field * 2;
+    if ((entry + 2) > vtable_size_) {
+      return 0;
+    }
+
+    return read<uint16_t>(vtable_pos_ + entry);
+  }
+
+  int64_t indirect(int field) const {
+    uint16_t offset = field_offset(field);
+    if (offset == 0) {
+      return -1;
+    }
+
+    return pos_ + offset + read<uint32_t>(pos_ + offset);
+  }
+};
+
+struct ArrayPrivate {
+  std::shared_ptr<MappedFile> file;
+  std::vector<const void*> buffers;
+  std::vector<struct ArrowArray*> children;
+};
+
+}
+
+class Reader {
+public:
+  Reader(): file_(new MappedFile()) {}
+
+  void open(const std::string& path) {
+    if (!host_is_little_endian()) {
+      throw util::Exception("IPC reader is not supported on big endian platforms");
+    }
+
+    // Arrays and streams exported from a previous file keep their own
+    // reference to it
+    file_ = std::shared_ptr<MappedFile>(new MappedFile());
+    file_->open(path);
+    blocks_.clear();
+
+    const uint8_t* data = file_->data();
+    int64_t size = file_->size();
+    bool is_file_format = size >= (kFileMagicSize * 2 + 4) &&
+      memcmp(data, kFileMagic, kFileMagicSize) == 0 &&
+      memcmp(data + size - kFileMagicSize, kFileMagic, kFileMagicSize) == 0;
+
+    if (is_file_format) {
+      read_footer();
+    } else {
+      scan_stream(0);
+    }
+  }
+
+  int64_t num_batches() const { return blocks_.size(); }
+
+  int64_t num_columns() const { return schema_.children.size(); }
+
+  // Returns the (zero-based) index of the top-level column with a given name
+  // or -1 if there is no such column
+  int64_t column_index(const std::string& name) const {
+    for (size_t i = 0; i < schema_.children.size(); i++) {
+      if (schema_.children[i].name == name) {
+        return i;
+      }
+    }
+
+    return -1;
+  }
+
+  // Export the schema of the record batches (column = -1) or a single
+  // top-level column
+  void get_schema(struct ArrowSchema* out, int64_t column = -1) const {
+    export_schema(field(column), out);
+  }
+
+  // Export the record batch i as a struct array (column = -1) or export a
+  // single top-level column of that record batch
+  void get_batch(int64_t i, struct ArrowArray* out, int64_t column = -1) const {
+    if (i < 0 || i >= num_batches()) {
+      throw util::Exception("Batch index %lld is out of range", (long long) i);
+    }
+
+    const internal::Block& block = blocks_[i];
+    internal::FlatbufferTable message = read_message(block.offset, nullptr);
+    if (message.scalar<uint8_t>(field::MESSAGE_HEADER_TYPE, HEADER_NONE) != HEADER_RECORD_BATCH) {
+      throw util::Exception("Expected RecordBatch message at offset %lld",
+                            (long long) block.offset);
+    }
+
+    internal::FlatbufferTable batch = message.table(field::MESSAGE_HEADER);
+    if (batch.has(field::RECORD_BATCH_COMPRESSION)) {
+      throw util::Exception("Compressed IPC record batches are not supported");
+    }
+
+    BatchLoader loader;
+    loader.file = file_;
+    loader.batch = batch;
+    loader.body_offset = block.offset + block.metadata_length;
+    loader.body_length = message.scalar<int64_t>(field::MESSAGE_BODY_LENGTH, 0);
+    if (loader.body_length < 0 || (loader.body_offset + loader.body_length) > file_->size()) {
+      throw util::Exception("IPC message body at offset %lld is outside the file",
+                            (long long) loader.body_offset);
+    }
+
+    loader.n_nodes = batch.vector(field::RECORD_BATCH_NODES, &loader.nodes_pos);
+    loader.n_buffers = batch.vector(field::RECORD_BATCH_BUFFERS, &loader.buffers_pos);
+    loader.node_i = 0;
+    loader.buffer_i = 0;
+
+    if (column < 0) {
+      // There is no field node for the record batch itself
+      loader.load_struct(schema_, batch.scalar<int64_t>(field::RECORD_BATCH_LENGTH, 0), out);
+      return;
+    }
+
+    // Skip the nodes/buffers for preceding columns
+    if (column >= num_columns()) {
+      throw util::Exception("Column index %lld is out of range", (long long) column);
+    }
+
+    for (int64_t j = 0; j < column; j++) {
+      loader.skip(schema_.children[j]);
+    }
+
+    loader.load(schema_.children[column], out);
+  }
+
+  // Export an ArrowArrayStream of all record batches (column = -1) or of
+  // a single top-level column. The stream keeps its own reference to
+  // the mapped file.
+  void export_stream(struct ArrowArrayStream* out, int64_t column = -1) const;
+
+private:
+  std::shared_ptr<MappedFile> file_;
+  internal::FieldInfo schema_;
+  std::vector<internal::Block> blocks_;
+
+  const internal::FieldInfo& field(int64_t column) const {
+    if (column < 0) {
+      return schema_;
+    } else if (column >= num_columns()) {
+      throw util::Exception("Column index %lld is out of range", (long long) column);
+    } else {
+      return schema_.children[column];
+    }
+  }
+
+  // Reads the encapsulated message at offset, setting *next_offset to the
+  // offset after the message and its body. Returns a null table for the
+  // end-of-stream marker.
+  internal::FlatbufferTable read_message(int64_t offset, int64_t* next_offset) const {
+    const uint8_t* data = file_->data();
+    int64_t size = file_->size();
+
+    if ((offset + 4) > size) {
+      return internal::FlatbufferTable();
+    }
+
+    int32_t metadata_size;
+    memcpy(&metadata_size, data + offset, sizeof(int32_t));
+    int64_t prefix_size = 4;
+
+    if (metadata_size == kContinuation) {
+      if ((offset + 8) > size) {
+        return internal::FlatbufferTable();
+      }
+
+      memcpy(&metadata_size, data + offset + 4, sizeof(int32_t));
+      prefix_size = 8;
+    }
+
+    if (metadata_size == 0) {
+      return internal::FlatbufferTable();
+    }
+
+    int64_t metadata_offset = offset + prefix_size;
+    if (metadata_size < 0 || (metadata_offset + metadata_size) > size) {
+      throw util::Exception("Invalid IPC message at offset %lld", (long long) offset);
+    }
+
+    internal::FlatbufferTable message = internal::FlatbufferTable::root(
+      data + metadata_offset, metadata_size);
+
+    if (next_offset != nullptr) {
+      int64_t body_length = message.scalar<int64_t>(field::MESSAGE_BODY_LENGTH, 0);
+      *next_offset = metadata_offset + metadata_size + body_length;
+    }
+
+    return message;
+  }
+
+  void scan_stream(int64_t offset) {
+    bool has_schema = false;
+    int64_t next_offset;
+
+    while (true) {
+      internal::FlatbufferTable message = read_message(offset, &next_offset);
+      if (message.is_null()) {
+        break;
+      }
+
+      uint8_t header_type = message.scalar<uint8_t>(field::MESSAGE_HEADER_TYPE, HEADER_NONE);
+      switch (header_type) {
+      case HEADER_SCHEMA:
+        read_schema(message.table(field::MESSAGE_HEADER));
+        has_schema = true;
+        break;
+      case HEADER_DICTIONARY_BATCH:
+        throw util::Exception("Dictionary-encoded IPC fields are not supported");
+      case HEADER_RECORD_BATCH: {
+        internal::Block block;
+        block.offset = offset;
+        block.body_length = message.scalar<int64_t>(field::MESSAGE_BODY_LENGTH, 0);
+        block.metadata_length = next_offset - offset - block.body_length;
+        blocks_.push_back(block);
+        break;
+      }
+      default:
+        throw util::Exception("Unsupported IPC message header type %d", (int) header_type);
+      }
+
+      offset = next_offset;
+    }
+
+    if (!has_schema) {
+      throw util::Exception("IPC stream does not contain a Schema message");
+    }
+  }
+
+  void read_footer() {
+    const uint8_t* data = file_->data();
+    int64_t size = file_->size();
+
+    int32_t footer_size;
+    memcpy(&footer_size, data + size - kFileMagicSize - 4, sizeof(int32_t));
+    int64_t footer_offset = size - kFileMagicSize - 4 - footer_size;
+    if (footer_size <= 0 || footer_offset < kFileMagicSize) {
+      throw util::Exception("Invalid IPC file footer size: %d", (int) footer_size);
+    }
+
+    internal::FlatbufferTable footer = internal::FlatbufferTable::root(
+      data + footer_offset, footer_size);
+
+    read_schema(footer.table(field::FOOTER_SCHEMA));
+
+    int64_t pos;
+    int64_t n = footer.vector(field::FOOTER_DICTIONARIES, &pos);
+    if (n > 0) {
+      throw util::Exception("Dictionary-encoded IPC fields are not supported");
+    }
+
+    n = footer.vector(field::FOOTER_RECORD_BATCHES, &pos);
+    for (int64_t i = 0; i < n; i++) {
+      // struct Block { offset: long; metaDataLength: int; (padding); bodyLength: long; }
+      int64_t block_pos = pos + i * 24;
+      internal::Block block;
+      block.offset = footer.read<int64_t>(block_pos);
+      block.metadata_length = footer.read<int32_t>(block_pos + 8);
+      block.body_length = footer.read<int64_t>(block_pos + 16);
+      blocks_.push_back(block);
+    }
+  }
+
+  void read_schema(const internal::FlatbufferTable& schema) {
+    if (schema.is_null()) {
+      throw util::Exception("IPC Schema is missing");
+    }
+
+    if (schema.scalar<int16_t>(field::SCHEMA_ENDIANNESS, 0) != 0) {
+      throw util::Exception("Big endian IPC data is not supported");
+    }
+
+    schema_ = internal::FieldInfo();
+    schema_.format = "+s";
+    schema_.flags = 0;
+    read_metadata(schema, field::SCHEMA_METADATA, &schema_);
+
+    int64_t pos;
+    int64_t n = schema.vector(field::SCHEMA_FIELDS, &pos);
+    for (int64_t i = 0; i < n; i++) {
+      schema_.children.push_back(read_field(schema.vector_table(pos, i)));
+    }
+  }
+
+  static void read_metadata(const internal::FlatbufferTable& table, int field_id,
+                            internal::FieldInfo* out) {
+    int64_t pos;
+    int64_t n = table.vector(field_id, &pos);
+    for (int64_t i = 0; i < n; i++) {
+      internal::FlatbufferTable key_value = table.vector_table(pos, i);
+      out->metadata_names.push_back(key_value.string(field::KEY_VALUE_KEY));
+      out->metadata_values.push_back(key_value.string(field::KEY_VALUE_VALUE));
+    }
+  }
+
+  static internal::FieldInfo read_field(const internal::FlatbufferTable& field_table) {
+    internal::FieldInfo out;
+    out.name = field_table.string(field::FIELD_NAME);
+    out.flags = field_table.scalar<uint8_t>(field::FIELD_NULLABLE, 0) ? ARROW_FLAG_NULLABLE : 0;
+
+    if (field_table.has(field::FIELD_DICTIONARY)) {
+      throw util::Exception("Dictionary-encoded IPC fields are not supported");
+    }
+
+    read_metadata(field_table, field::FIELD_METADATA, &out);
+
+    int64_t pos;
+    int64_t n = field_table.vector(field::FIELD_CHILDREN, &pos);
+    for (int64_t i = 0; i < n; i++) {
+      out.children.push_back(read_field(field_table.vector_table(pos, i)));
+    }
+
+    uint8_t type_type = field_table.scalar<uint8_t>(field::FIELD_TYPE_TYPE, TYPE_NONE);
+    out.format = read_format(type_type, field_table.table(field::FIELD_TYPE), n);
+    return out;
+  }
+
+  static std::string read_format(uint8_t type_type, const internal::FlatbufferTable& type,
+                                 int64_t n_children) {
+    static const char time_units[] = {'s', 'm', 'u', 'n'};
+    char out[128];
+
+    switch (type_type) {
+    case TYPE_NULL:
+      return "n";
+    case TYPE_INT: {
+      int32_t bit_width = type.scalar<int32_t>(0, 0);
+      bool is_signed = type.scalar<uint8_t>(1, 0);
+      switch (bit_width) {
+      case 8: return is_signed ? "c" : "C";
+      case 16: return is_signed ? "s" : "S";
+      case 32: return is_signed ? "i" : "I";
+      case 64: return is_signed ? "l" : "L";
+      default: throw util::Exception("Unsupported Int bitWidth %d", (int) bit_width);
+      }
+    }
+    case TYPE_FLOATING_POINT:
+      switch (type.scalar<int16_t>(0, 0)) {
+      case 0: return "e";
+      case 1: return "f";
+      case 2: return "g";
+      default: throw util::Exception("Unsupported FloatingPoint precision");
+      }
+    case TYPE_BINARY:
+      return "z";
+    case TYPE_UTF8:
+      return "u";
+    case TYPE_BOOL:
+      return "b";
+    case TYPE_DECIMAL: {
+      int32_t bit_width = type.scalar<int32_t>(2, 128);
+      if (bit_width == 128) {
+        snprintf(out, sizeof(out), "d:%d,%d",
+                 (int) type.scalar<int32_t>(0, 0), (int) type.scalar<int32_t>(1, 0));
+      } else {
+        snprintf(out, sizeof(out), "d:%d,%d,%d",
+                 (int) type.scalar<int32_t>(0, 0), (int) type.scalar<int32_t>(1, 0),
+                 (int) bit_width);
+      }
+      return out;
+    }
+    case TYPE_DATE:
+      return type.scalar<int16_t>(0, 1) == 0 ? "tdD" : "tdm";
+    case TYPE_TIME:
+    case TYPE_DURATION: {
+      int16_t unit = type.scalar<int16_t>(0, 1);
+      if (unit < 0 || unit > 3) {
+        throw util::Exception("Unsupported TimeUnit %d", (int) unit);
+      }
+      snprintf(out, sizeof(out), "%s%c", type_type == TYPE_TIME ? "tt" : "tD", time_units[unit]);
+      return out;
+    }
+    case TYPE_TIMESTAMP: {
+      int16_t unit = type.scalar<int16_t>(0, 0);
+      if (unit < 0 || unit > 3) {
+        throw util::Exception("Unsupported TimeUnit %d", (int) unit);
+      }
+      std::string timezone = type.string(1);
+      snprintf(out, sizeof(out), "ts%c:", time_units[unit]);
+      return std::string(out) + timezone;
+    }
+    case TYPE_INTERVAL:
+      switch (type.scalar<int16_t>(0, 0)) {
+      case 0: return "tiM";
+      case 1: return "tiD";
+      case 2: return "tin";
+      default: throw util::Exception("Unsupported IntervalUnit");
+      }
+    case TYPE_LIST:
+      return "+l";
+    case TYPE_LARGE_LIST:
+      return "+L";
+    case TYPE_STRUCT:
+      return "+s";
+    case TYPE_MAP:
+      return "+m";
+    case TYPE_FIXED_SIZE_BINARY:
+      snprintf(out, sizeof(out), "w:%d", (int) type.scalar<int32_t>(0, 0));
+      return out;
+    case TYPE_FIXED_SIZE_LIST:
+      snprintf(out, sizeof(out), "+w:%d", (int) type.scalar<int32_t>(0, 0));
+      return out;
+    case TYPE_LARGE_BINARY:
+      return "Z";
+    case TYPE_LARGE_UTF8:
+      return "U";
+    case TYPE_UNION: {
+      std::string format = type.scalar<int16_t>(0, 0) == 1 ? "+ud:" : "+us:";
+      int64_t pos;
+      int64_t n_type_ids = type.vector(1, &pos);
+      for (int64_t i = 0; i < n_children; i++) {
+        int32_t type_id = i < n_type_ids ? type.read<int32_t>(pos + i * 4) : i;
+        if (i > 0) {
+          format += ",";
+        }
+        format += std::to_string(type_id);
+      }
+      return format;
+    }
+    default:
+      throw util::Exception("Unsupported IPC field type %d", (int) type_type);
+    }
+  }
+
+  static void export_schema(const internal::FieldInfo& field, struct ArrowSchema* out) {
+    SchemaFinalizer finalizer;
+    finalizer.allocate(field.children.size());
+    finalizer.set_format(field.format.c_str());
+    finalizer.set_name(field.name.c_str());
+    if (field.metadata_names.size() > 0) {
+      finalizer.set_metadata(field.metadata_names, field.metadata_values);
+    }
+    finalizer.schema.flags = field.flags;
+
+    for (size_t i = 0; i < field.children.size(); i++) {
+      export_schema(field.children[i], finalizer.schema.children[i]);
+    }
+
+    finalizer.release(out);
+  }
+
+  // Walks the (depth-first) nodes and buffers of a RecordBatch message,
+  // creating struct ArrowArrays that point into the mapped file
+  class BatchLoader {
+  public:
+    std::shared_ptr<MappedFile> file;
+    internal::FlatbufferTable batch;
+    int64_t body_offset;
+    int64_t body_length;
+    int64_t nodes_pos;
+    int64_t n_nodes;
+    int64_t buffers_pos;
+    int64_t n_buffers;
+    int64_t node_i;
+    int64_t buffer_i;
+
+    void skip(const internal::FieldInfo& field) {
+      node_i++;
+      buffer_i += format_n_buffers(field.format);
+      for (const auto& child: field.children) {
+        skip(child);
+      }
+    }
+
+    void load(const internal::FieldInfo& field, struct ArrowArray* out) {
+      if (node_i >= n_nodes) {
+        throw util::Exception("IPC RecordBatch has too few field nodes");
+      }
+
+      // struct FieldNode { length: long; null_count: long; }
+      int64_t node_pos = nodes_pos + node_i * 16;
+      int64_t length = batch.read<int64_t>(node_pos);
+      int64_t null_count = batch.read<int64_t>(node_pos + 8);
+      node_i++;
+
+      std::unique_ptr<internal::ArrayPrivate> private_data(new internal::ArrayPrivate());
+      private_data->file = file;
+
+      // Unions don't have a validity buffer
+      bool has_validity = field.format.substr(0, 2) != "+u";
+      int64_t n_array_buffers = format_n_buffers(field.format);
+      for (int64_t i = 0; i < n_array_buffers; i++) {
+        private_data->buffers.push_back(load_buffer(has_validity && i == 0));
+      }
+
+      finish(field, length, null_count, std::move(private_data), out);
+    }
+
+    void load_struct(const internal::FieldInfo& field, int64_t length,
+                     struct ArrowArray* out) {
+      std::unique_ptr<internal::ArrayPrivate> private_data(new internal::ArrayPrivate());
+      private_data->file = file;
+      private_data->buffers.push_back(nullptr);
+      finish(field, length, 0, std::move(private_data), out);
+    }
+
+  private:
+    void finish(const internal::FieldInfo& field, int64_t length, int64_t null_count,
+                std::unique_ptr<internal::ArrayPrivate> private_data,
+                struct ArrowArray* out) {
+      // Make sure children are released if loading a child fails
+      struct ArrowArray tmp;
+      tmp.n_buffers = private_data->buffers.size();
+      tmp.n_children = 0;
+      tmp.buffers = private_data->buffers.data();
+      tmp.children = nullptr;
+      tmp.dictionary = nullptr;
+      tmp.private_data = private_data.release();
+      tmp.release = &arrow_hpp_ipc_release_array_internal;
+      auto tmp_private = reinterpret_cast<internal::ArrayPrivate*>(tmp.private_data);
+
+      try {
+        for (size_t i = 0; i < field.children.size(); i++) {
+          struct ArrowArray* child = new struct ArrowArray;
+          child->release = nullptr;
+          tmp_private->children.push_back(child);
+          load(field.children[i], child);
+        }
+      } catch (std::exception& e) {
+        tmp.release(&tmp);
+        throw;
+      }
+
+      out->length = length;
+      out->null_count = null_count;
+      out->offset = 0;
+      out->n_buffers = tmp.n_buffers;
+      out->n_children = field.children.size();
+      out->buffers = tmp_private->buffers.data();
+      out->children = tmp_private->children.data();
+      out->dictionary = nullptr;
+      out->private_data = tmp_private;
+      out->release = &arrow_hpp_ipc_release_array_internal;
+    }
+
+    const void* load_buffer(bool is_validity) {
+      if (buffer_i >= n_buffers) {
+        throw util::Exception("IPC RecordBatch has too few buffers");
+      }
+
+      // struct Buffer { offset: long; length: long; }
+      int64_t buffer_pos = buffers_pos + buffer_i * 16;
+      int64_t offset = batch.read<int64_t>(buffer_pos);
+      int64_t length = batch.read<int64_t>(buffer_pos + 8);
+      buffer_i++;
+
+      if (offset < 0 || length < 0 || (offset + length) > body_length) {
+        throw util::Exception("IPC buffer is outside the message body");
+      }
+
+      if (length == 0 && is_validity) {
+        // A zero-length validity buffer means there are no nulls
+        return nullptr;
+      } else if (length == 0) {
+        // Zero-length offset buffers are permitted for zero-length arrays
+        // but consumers may still read the first element
+        static const int64_t empty_buffer[2] = {0, 0};
+        return empty_buffer;
+      }
+
+      return file->data() + body_offset + offset;
+    }
+  };
+};
+
+namespace internal {
+
+struct StreamPrivate {
+  std::shared_ptr<Reader> reader;
+  int64_t column;
+  int64_t next_batch;
+  std::string last_error;
+};
+
+}
+
+inline void Reader::export_stream(struct ArrowArrayStream* out, int64_t column) const {
+  // validate the column before creating the stream
+  field(column);
+
+  std::unique_ptr<internal::StreamPrivate> private_data(new internal::StreamPrivate());
+  private_data->reader = std::shared_ptr<Reader>(new Reader(*this));
+  private_data->column = column;
+  private_data->next_batch = 0;
+
+  out->get_schema = &arrow_hpp_ipc_stream_get_schema;
+  out->get_next = &arrow_hpp_ipc_stream_get_next;
+  out->get_last_error = &arrow_hpp_ipc_stream_get_last_error;
+  out->release = &arrow_hpp_ipc_stream_release;
+  out->private_data = private_data.release();
+}
+
+}
+
+}
+
+}
+
+#ifdef ARROW_HPP_IMPL
+
+void arrow_hpp_ipc_release_array_internal(struct ArrowArray* array_data) {
+  if (array_data == nullptr || array_data->release == nullptr) {
+    return;
+  }
+
+  auto private_data = reinterpret_cast<arrow::hpp::ipc::internal::ArrayPrivate*>(
+    array_data->private_data);
+
+  // The children are owned by this array but may have been moved
+  // (i.e., their release callback set to nullptr)
+  for (struct ArrowArray* child: private_data->children) {
+    if (child->release != nullptr) {
+      child->release(child);
+    }
+
+    delete child;
+  }
+
+  // Drops the reference to the mapped file
+  delete private_data;
+  array_data->release = nullptr;
+}
+
+int arrow_hpp_ipc_stream_get_schema(struct ArrowArrayStream* stream,
+                                    struct ArrowSchema* out) {
+  auto private_data = reinterpret_cast<arrow::hpp::ipc::internal::StreamPrivate*>(
+    stream->private_data);
+
+  try {
+    out->release = nullptr;
+    private_data->reader->get_schema(out, private_data->column);
+    return 0;
+  } catch (std::exception& e) {
+    private_data->last_error = e.what();
+    return EINVAL;
+  }
+}
+
+int arrow_hpp_ipc_stream_get_next(struct ArrowArrayStream* stream,
+                                  struct ArrowArray* out) {
+  auto private_data = reinterpret_cast<arrow::hpp::ipc::internal::StreamPrivate*>(
+    stream->private_data);
+
+  try {
+    if (private_data->next_batch >= private_data->reader->num_batches()) {
+      out->release = nullptr;
+      return 0;
+    }
+
+    private_data->reader->get_batch(
+      private_data->next_batch,
+      out,
+      private_data->column);
+    private_data->next_batch++;
+    return 0;
+  } catch (std::exception& e) {
+    private_data->last_error = e.what();
+    return EINVAL;
+  }
+}
+
+const char* arrow_hpp_ipc_stream_get_last_error(struct ArrowArrayStream* stream) {
+  auto private_data = reinterpret_cast<arrow::hpp::ipc::internal::StreamPrivate*>(
+    stream->private_data);
+  return private_data->last_error.c_str();
+}
+
+void arrow_hpp_ipc_stream_release(struct ArrowArrayStream* stream) {
+  if (stream == nullptr || stream->release == nullptr) {
+    return;
+  }
+
+  delete reinterpret_cast<arrow::hpp::ipc::internal::StreamPrivate*>(stream->private_data);
+  stream->release = nullptr;
+}
+
+#endif
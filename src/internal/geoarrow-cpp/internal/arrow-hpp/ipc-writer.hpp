@@ -0,0 +1,976 @@
+
+#pragma once
+
+#include <cerrno>
+#include <climits>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <utility>
+#include <vector>
+
+#if defined(_WIN32)
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
+#else
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#endif
+
+#include "common.hpp"
+#include "schema.hpp"
+#include "ipc-common.hpp"
+
+// A writer for the Arrow IPC stream and file (i.e., Feather version 2)
+// formats. Buffers of the struct ArrowArrays passed to write_batch() are
+// written directly from their original location using writev() (i.e.,
+// they are not copied into an intermediary message buffer) except where
+// an array offset requires that a validity bitmap be shifted or offsets
+// be rebased to zero. Schema and field metadata (including extension
+// type metadata) are written as-is. Dictionary-encoded fields are not
+// supported and batches are never compressed.
+
+namespace arrow {
+
+namespace hpp {
+
+namespace ipc {
+
+namespace internal {
+
+// A flatbuffer table, string, or vector whose children are serialized
+// after it. This is the opposite of how the flatbuffers library builds
+// buffers (back to front) but makes it possible to build a message
+// as a tree: all uoffset_t values still point forward in the buffer.
+class FlatbufferNode {
+public:
+  enum Kind { TABLE, STRING, TABLE_VECTOR, STRUCT_VECTOR };
+
+  static std::shared_ptr<FlatbufferNode> table() {
+    return std::shared_ptr<FlatbufferNode>(new FlatbufferNode(TABLE));
+  }
+
+  static std::shared_ptr<FlatbufferNode> string(const std::string& value) {
+    std::shared_ptr<FlatbufferNode> node(new FlatbufferNode(STRING));
+    node->data_ = value;
+    return node;
+  }
+
+  static std::shared_ptr<FlatbufferNode> table_vector(
+      const std::vector<std::shared_ptr<FlatbufferNode>>& tables) {
+    std::shared_ptr<FlatbufferNode> node(new FlatbufferNode(TABLE_VECTOR));
+    node->children_ = tables;
+    return node;
+  }
+
+  // A vector of structs or scalars whose elements are already serialized
+  // in data
+  static std::shared_ptr<FlatbufferNode> struct_vector(const std::string& data,
+                                                       int64_t n_elements,
+                                                       int64_t alignment) {
+    std::shared_ptr<FlatbufferNode> node(new FlatbufferNode(STRUCT_VECTOR));
+    node->data_ = data;
+    node->n_elements_ = n_elements;
+    node->alignment_ = alignment;
+    return node;
+  }
+
+  template <typename T>
+  void add_scalar(int field_id, T value) {
+    InlineField field;
+    field.id = field_id;
+    field.value = std::string(reinterpret_cast<const char*>(&value), sizeof(T));
+    fields_.push_back(field);
+  }
+
+  void add_child(int field_id, std::shared_ptr<FlatbufferNode> child) {
+    InlineField field;
+    field.id = field_id;
+    field.value = std::string(4, '\0');
+    field.child = child;
+    fields_.push_back(field);
+  }
+
+  // Serializes the tree rooted at this table into a buffer whose size
+  // is a multiple of 8 bytes
+  std::string finish() {
+    std::string out(8, '\0');
+    uint32_t root_offset = write(&out);
+    memcpy(&out[0], &root_offset, sizeof(uint32_t));
+    out.resize(padded_size(out.size()), '\0');
+    return out;
+  }
+
+private:
+  struct InlineField {
+    int id;
+    std::string value;
+    std::shared_ptr<FlatbufferNode> child;
+  };
+
+  Kind kind_;
+  std::string data_;
+  int64_t n_elements_;
+  int64_t alignment_;
+  std::vector<InlineField> fields_;
+  std::vector<std::shared_ptr<FlatbufferNode>> children_;
+
+  FlatbufferNode(Kind kind): kind_(kind), n_elements_(0), alignment_(1) {}
+
+  static void align(std::string* out, int64_t alignment) {
+    out->resize(padded_size(out->size(), alignment), '\0');
+  }
+
+  static void patch_offset(std::string* out, int64_t slot_pos, int64_t child_pos) {
+    uint32_t offset = child_pos - slot_pos;
+    memcpy(&(*out)[slot_pos], &offset, sizeof(uint32_t));
+  }
+
+  template <typename T>
+  static void append(std::string* out, T value) {
+    out->append(reinterpret_cast<const char*>(&value), sizeof(T));
+  }
+
+  // Returns the position of the serialized object in out
+  int64_t write(std::string* out) {
+    switch (kind_) {
+    case STRING: {
+      align(out, 4);
+      int64_t pos = out->size();
+      append<uint32_t>(out, data_.size());
+      out->append(data_);
+      out->push_back('\0');
+      return pos;
+    }
+
+    case STRUCT_VECTOR: {
+      // The first element (not the length) must be aligned
+      align(out, 4);
+      while (((out->size() + 4) % alignment_) != 0) {
+        out->push_back('\0');
+      }
+
+      int64_t pos = out->size();
+      append<uint32_t>(out, n_elements_);
+      out->append(data_);
+      return pos;
+    }
+
+    case TABLE_VECTOR: {
+      align(out, 4);
+      int64_t pos = out->size();
+      append<uint32_t>(out, children_.size());
+      out->append(children_.size() * 4, '\0');
+      for (size_t i = 0; i < children_.size(); i++) {
+        int64_t child_pos = children_[i]->write(out);
+        patch_offset(out, pos + 4 + i * 4, child_pos);
+      }
+      return pos;
+    }
+
+    default:
+      return write_table(out);
+    }
+  }
+
+  int64_t write_table(std::string* out) {
+    // Lay out the inline fields after the soffset_t to the vtable
+    int max_id = -1;
+    int64_t table_size = 4;
+    std::vector<int64_t> field_offsets(fields_.size());
+    for (size_t i = 0; i < fields_.size(); i++) {
+      int64_t size = fields_[i].value.size();
+      table_size = padded_size(table_size, size);
+      field_offsets[i] = table_size;
+      table_size += size;
+      if (fields_[i].id > max_id) {
+        max_id = fields_[i].id;
+      }
+    }
+
+    std::vector<uint16_t> vtable(2 + max_id + 1, 0);
+    vtable[0] = vtable.size() * 2;
+    vtable[1] = table_size;
+    for (size_t i = 0; i < fields_.size(); i++) {
+      vtable[2 + fields_[i].id] = field_offsets[i];
+    }
+
+    align(out, 2);
+    int64_t vtable_pos = out->size();
+    out->append(reinterpret_cast<const char*>(vtable.data()), vtable.size() * 2);
+
+    // Aligning the start of the table to 8 bytes ensures that all scalars
+    // are aligned relative to the start of the buffer
+    align(out, 8);
+    int64_t pos = out->size();
+    out->append(table_size, '\0');
+    int32_t vtable_offset = pos - vtable_pos;
+    memcpy(&(*out)[pos], &vtable_offset, sizeof(int32_t));
+    for (size_t i = 0; i < fields_.size(); i++) {
+      memcpy(&(*out)[pos + field_offsets[i]], fields_[i].value.data(),
+             fields_[i].value.size());
+    }
+
+    for (size_t i = 0; i < fields_.size(); i++) {
+      if (fields_[i].child) {
+        int64_t child_pos = fields_[i].child->write(out);
+        patch_offset(out, pos + field_offsets[i], child_pos);
+      }
+    }
+
+    return pos;
+  }
+};
+
+struct IOBuffer {
+  const void* data;
+  int64_t size;
+};
+
+// An output file descriptor that writes lists of buffers with as few
+// system calls as possible
+class OutputFile {
+public:
+  OutputFile(): fd_(-1), owns_fd_(false) {}
+
+  ~OutputFile() {
+    try {
+      close();
+    } catch (...) {
+      // Destructors can't throw
+    }
+  }
+
+  void open(const std::string& path) {
+    close();
+#if defined(_WIN32)
+    fd_ = ::_open(path.c_str(), _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY,
+                  _S_IREAD | _S_IWRITE);
+#else
+    fd_ = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+#endif
+    if (fd_ < 0) {
+      throw util::Exception("Failed to open '%s' for writing", path.c_str());
+    }
+
+    owns_fd_ = true;
+  }
+
+  void open_fd(int fd) {
+    close();
+    fd_ = fd;
+    owns_fd_ = false;
+  }
+
+  bool is_open() const { return fd_ >= 0; }
+
+  void write(const std::vector<IOBuffer>& buffers) {
+    if (fd_ < 0) {
+      throw util::Exception("Can't write to a closed output file");
+    }
+
+#if defined(_WIN32)
+    for (const IOBuffer& buffer: buffers) {
+      const char* data = reinterpret_cast<const char*>(buffer.data);
+      int64_t remaining = buffer.size;
+      while (remaining > 0) {
+        unsigned int chunk_size = remaining > INT_MAX ? INT_MAX : remaining;
+        int bytes_written = ::_write(fd_, data, chunk_size);
+        if (bytes_written < 0) {
+          throw util::Exception("Write failed with errno %d", errno);
+        }
+
+        data += bytes_written;
+        remaining -= bytes_written;
+      }
+    }
+#else
+#if defined(IOV_MAX)
+    const size_t max_iov = IOV_MAX;
+#else
+    const size_t max_iov = 16;
+#endif
+
+    std::vector<struct iovec> iov;
+    for (const IOBuffer& buffer: buffers) {
+      if (buffer.size > 0) {
+        struct iovec item;
+        item.iov_base = const_cast<void*>(buffer.data);
+        item.iov_len = buffer.size;
+        iov.push_back(item);
+      }
+    }
+
+    size_t i = 0;
+    while (i < iov.size()) {
+      size_t n = iov.size() - i;
+      if (n > max_iov) {
+        n = max_iov;
+      }
+
+      ssize_t bytes_written = ::writev(fd_, iov.data() + i, n);
+      if (bytes_written < 0 && errno == EINTR) {
+        continue;
+      } else if (bytes_written < 0) {
+        throw util::Exception("writev() failed with errno %d", errno);
+      }
+
+      // Skip buffers that were written completely and advance into
+      // the first buffer that was written partially
+      size_t remaining = bytes_written;
+      while (i < iov.size() && remaining >= iov[i].iov_len) {
+        remaining -= iov[i].iov_len;
+        i++;
+      }
+
+      if (remaining > 0) {
+        iov[i].iov_base = reinterpret_cast<char*>(iov[i].iov_base) + remaining;
+        iov[i].iov_len -= remaining;
+      }
+    }
+#endif
+  }
+
+  void close() {
+    if (owns_fd_ && fd_ >= 0) {
+#if defined(_WIN32)
+      int result = ::_close(fd_);
+#else
+      int result = ::close(fd_);
+#endif
+      fd_ = -1;
+      if (result != 0) {
+        throw util::Exception("Failed to close output file (errno %d)", errno);
+      }
+    }
+
+    fd_ = -1;
+    owns_fd_ = false;
+  }
+
+private:
+  int fd_;
+  bool owns_fd_;
+};
+
+}
+
+class Writer {
+public:
+  Writer(): file_format_(false), wrap_column_(false), position_(0) {}
+
+  // Opens path for writing in the IPC file format (file_format = true)
+  // or IPC stream format
+  void open(const std::string& path, bool file_format = false) {
+    check_endian();
+    file_.open(path);
+    start(file_format);
+  }
+
+  // Writes to an existing file descriptor (e.g., a pipe or socket) that
+  // is not closed by close()
+  void open_fd(int fd, bool file_format = false) {
+    check_endian();
+    file_.open_fd(fd);
+    start(file_format);
+  }
+
+  // Writes the schema message for record batches with one column
+  // per child of schema (whose format must be "+s")
+  void write_schema(const struct ArrowSchema* schema) {
+    if (std::string(schema->format) != "+s") {
+      throw util::Exception(
+        "Expected schema with format '+s' but got '%s'", schema->format);
+    }
+
+    schema_ = field_info(schema);
+    wrap_column_ = false;
+    write_schema_message();
+  }
+
+  // Writes the schema message for record batches with a single column
+  // (e.g., the output of a ComputeBuilder)
+  void write_column_schema(const struct ArrowSchema* schema, const std::string& name) {
+    schema_ = internal::FieldInfo();
+    schema_.format = "+s";
+    schema_.flags = 0;
+    schema_.children.push_back(field_info(schema));
+    schema_.children[0].name = name;
+    wrap_column_ = true;
+    write_schema_message();
+  }
+
+  void write_batch(const struct ArrowArray* array) {
+    if (schema_.format.empty()) {
+      throw util::Exception("Can't write a record batch before the schema");
+    }
+
+    BatchWriter batch;
+    if (wrap_column_) {
+      batch.write_array(schema_.children[0], array, array->offset, array->length);
+    } else {
+      if (array->n_children != static_cast<int64_t>(schema_.children.size())) {
+        throw util::Exception(
+          "Expected array with %ld children but got array with %ld children",
+          (long) schema_.children.size(), (long) array->n_children);
+      }
+
+      for (int64_t i = 0; i < array->n_children; i++) {
+        const struct ArrowArray* child = array->children[i];
+        batch.write_array(schema_.children[i], child, child->offset + array->offset,
+                          array->length);
+      }
+    }
+
+    std::shared_ptr<internal::FlatbufferNode> record_batch = internal::FlatbufferNode::table();
+    record_batch->add_scalar<int64_t>(field::RECORD_BATCH_LENGTH, array->length);
+    record_batch->add_child(
+      field::RECORD_BATCH_NODES,
+      internal::FlatbufferNode::struct_vector(batch.nodes, batch.nodes.size() / 16, 8));
+    record_batch->add_child(
+      field::RECORD_BATCH_BUFFERS,
+      internal::FlatbufferNode::struct_vector(batch.buffers, batch.buffers.size() / 16, 8));
+
+    internal::Block block;
+    block.offset = position_;
+    block.body_length = batch.body_length;
+    block.metadata_length = write_message(HEADER_RECORD_BATCH, record_batch, batch.body);
+    blocks_.push_back(block);
+  }
+
+  // Writes the end-of-stream marker (and footer for the file format)
+  // and closes the file if it was opened by this Writer
+  void close() {
+    if (!file_.is_open()) {
+      return;
+    }
+
+    int32_t end_of_stream[2] = {kContinuation, 0};
+    std::vector<internal::IOBuffer> buffers;
+    buffers.push_back({end_of_stream, sizeof(end_of_stream)});
+
+    std::string footer;
+    int32_t footer_size = 0;
+    if (file_format_) {
+      footer = footer_flatbuffer();
+      footer_size = footer.size();
+      buffers.push_back({footer.data(), footer_size});
+      buffers.push_back({&footer_size, sizeof(int32_t)});
+      buffers.push_back({kFileMagic, kFileMagicSize});
+    }
+
+    file_.write(buffers);
+    file_.close();
+  }
+
+  int64_t num_batches() const { return blocks_.size(); }
+
+private:
+  internal::OutputFile file_;
+  internal::FieldInfo schema_;
+  std::vector<internal::Block> blocks_;
+  bool file_format_;
+  bool wrap_column_;
+  int64_t position_;
+
+  static void check_endian() {
+    if (!host_is_little_endian()) {
+      throw util::Exception("IPC writer is not supported on big endian platforms");
+    }
+  }
+
+  void start(bool file_format) {
+    file_format_ = file_format;
+    schema_ = internal::FieldInfo();
+    blocks_.clear();
+    position_ = 0;
+
+    if (file_format_) {
+      // The magic string padded to 8 bytes
+      static const char magic[8] = {'A', 'R', 'R', 'O', 'W', '1', '\0', '\0'};
+      std::vector<internal::IOBuffer> buffers;
+      buffers.push_back({magic, sizeof(magic)});
+      file_.write(buffers);
+      position_ += sizeof(magic);
+    }
+  }
+
+  void write_schema_message() {
+    std::vector<internal::IOBuffer> body;
+    write_message(HEADER_SCHEMA, schema_table(schema_), body);
+  }
+
+  // Writes an encapsulated message and its body, returning the length of the
+  // metadata (including the prefix and padding)
+  int32_t write_message(MessageHeader header_type,
+                        std::shared_ptr<internal::FlatbufferNode> header,
+                        const std::vector<internal::IOBuffer>& body) {
+    int64_t body_length = 0;
+    for (const internal::IOBuffer& buffer: body) {
+      body_length += buffer.size;
+    }
+
+    std::shared_ptr<internal::FlatbufferNode> message = internal::FlatbufferNode::table();
+    message->add_scalar<int16_t>(field::MESSAGE_VERSION, V5);
+    message->add_scalar<uint8_t>(field::MESSAGE_HEADER_TYPE, header_type);
+    message->add_child(field::MESSAGE_HEADER, header);
+    message->add_scalar<int64_t>(field::MESSAGE_BODY_LENGTH, body_length);
+
+    std::string metadata = message->finish();
+    int32_t prefix[2] = {kContinuation, static_cast<int32_t>(metadata.size())};
+
+    std::vector<internal::IOBuffer> buffers;
+    buffers.reserve(body.size() + 2);
+    buffers.push_back({prefix, sizeof(prefix)});
+    buffers.push_back({metadata.data(), static_cast<int64_t>(metadata.size())});
+    buffers.insert(buffers.end(), body.begin(), body.end());
+    file_.write(buffers);
+
+    int32_t metadata_length = sizeof(prefix) + metadata.size();
+    position_ += metadata_length + body_length;
+    return metadata_length;
+  }
+
+  std::string footer_flatbuffer() {
+    std::string blocks;
+    for (const internal::Block& block: blocks_) {
+      // struct Block { offset: long; metaDataLength: int; (padding); bodyLength: long; }
+      char item[24];
+      memset(item, 0, sizeof(item));
+      memcpy(item, &block.offset, sizeof(int64_t));
+      memcpy(item + 8, &block.metadata_length, sizeof(int32_t));
+      memcpy(item + 16, &block.body_length, sizeof(int64_t));
+      blocks.append(item, sizeof(item));
+    }
+
+    std::shared_ptr<internal::FlatbufferNode> footer = internal::FlatbufferNode::table();
+    footer->add_scalar<int16_t>(field::FOOTER_VERSION, V5);
+    footer->add_child(field::FOOTER_SCHEMA, schema_table(schema_));
+    footer->add_child(
+      field::FOOTER_DICTIONARIES,
+      internal::FlatbufferNode::struct_vector("", 0, 8));
+    footer->add_child(
+      field::FOOTER_RECORD_BATCHES,
+      internal::FlatbufferNode::struct_vector(blocks, blocks_.size(), 8));
+    return footer->finish();
+  }
+
+  static internal::FieldInfo field_info(const struct ArrowSchema* schema) {
+    if (schema->dictionary != nullptr) {
+      throw util::Exception("Dictionary-encoded IPC fields are not supported");
+    }
+
+    internal::FieldInfo out;
+    out.name = schema->name == nullptr ? "" : schema->name;
+    out.format = schema->format;
+    out.flags = schema->flags;
+    out.metadata_names = schema_metadata_names(schema->metadata);
+    for (const std::string& name: out.metadata_names) {
+      out.metadata_values.push_back(schema_metadata_key(schema->metadata, name));
+    }
+
+    for (int64_t i = 0; i < schema->n_children; i++) {
+      out.children.push_back(field_info(schema->children[i]));
+    }
+
+    return out;
+  }
+
+  static std::shared_ptr<internal::FlatbufferNode> metadata_vector(
+      const internal::FieldInfo& field) {
+    std::vector<std::shared_ptr<internal::FlatbufferNode>> key_values;
+    for (size_t i = 0; i < field.metadata_names.size(); i++) {
+      std::shared_ptr<internal::FlatbufferNode> key_value = internal::FlatbufferNode::table();
+      key_value->add_child(field::KEY_VALUE_KEY,
+                           internal::FlatbufferNode::string(field.metadata_names[i]));
+      key_value->add_child(field::KEY_VALUE_VALUE,
+                           internal::FlatbufferNode::string(field.metadata_values[i]));
+      key_values.push_back(key_value);
+    }
+
+    return internal::FlatbufferNode::table_vector(key_values);
+  }
+
+  static std::shared_ptr<internal::FlatbufferNode> schema_table(
+      const internal::FieldInfo& schema) {
+    std::vector<std::shared_ptr<internal::FlatbufferNode>> fields;
+    for (const internal::FieldInfo& child: schema.children) {
+      fields.push_back(field_table(child));
+    }
+
+    std::shared_ptr<internal::FlatbufferNode> out = internal::FlatbufferNode::table();
+    out->add_scalar<int16_t>(field::SCHEMA_ENDIANNESS, 0);
+    out->add_child(field::SCHEMA_FIELDS, internal::FlatbufferNode::table_vector(fields));
+    if (schema.metadata_names.size() > 0) {
+      out->add_child(field::SCHEMA_METADATA, metadata_vector(schema));
+    }
+
+    return out;
+  }
+
+  static std::shared_ptr<internal::FlatbufferNode> field_table(
+      const internal::FieldInfo& field) {
+    std::vector<std::shared_ptr<internal::FlatbufferNode>> children;
+    for (const internal::FieldInfo& child: field.children) {
+      children.push_back(field_table(child));
+    }
+
+    std::shared_ptr<internal::FlatbufferNode> type = internal::FlatbufferNode::table();
+    uint8_t type_type = write_type(field, type.get());
+
+    std::shared_ptr<internal::FlatbufferNode> out = internal::FlatbufferNode::table();
+    out->add_child(field::FIELD_NAME, internal::FlatbufferNode::string(field.name));
+    out->add_scalar<uint8_t>(field::FIELD_NULLABLE, (field.flags & ARROW_FLAG_NULLABLE) != 0);
+    out->add_scalar<uint8_t>(field::FIELD_TYPE_TYPE, type_type);
+    out->add_child(field::FIELD_TYPE, type);
+    out->add_child(field::FIELD_CHILDREN, internal::FlatbufferNode::table_vector(children));
+    if (field.metadata_names.size() > 0) {
+      out->add_child(field::FIELD_METADATA, metadata_vector(field));
+    }
+
+    return out;
+  }
+
+  static int16_t time_unit(char unit) {
+    switch (unit) {
+    case 's': return 0;
+    case 'm': return 1;
+    case 'u': return 2;
+    case 'n': return 3;
+    default: throw util::Exception("Unsupported time unit '%c'", unit);
+    }
+  }
+
+  // Populates the type table for a field, returning the Type enum value
+  static uint8_t write_type(const internal::FieldInfo& field, internal::FlatbufferNode* type) {
+    const std::string& format = field.format;
+
+    if (format.size() == 1) {
+      switch (format[0]) {
+      case 'n': return TYPE_NULL;
+      case 'b': return TYPE_BOOL;
+      case 'c': case 'C': case 's': case 'S':
+      case 'i': case 'I': case 'l': case 'L': {
+        static const std::string int_formats = "cCsSiIlL";
+        int64_t i = int_formats.find(format[0]);
+        type->add_scalar<int32_t>(0, 8 << (i / 2));
+        type->add_scalar<uint8_t>(1, (i % 2) == 0);
+        return TYPE_INT;
+      }
+      case 'e': type->add_scalar<int16_t>(0, 0); return TYPE_FLOATING_POINT;
+      case 'f': type->add_scalar<int16_t>(0, 1); return TYPE_FLOATING_POINT;
+      case 'g': type->add_scalar<int16_t>(0, 2); return TYPE_FLOATING_POINT;
+      case 'z': return TYPE_BINARY;
+      case 'u': return TYPE_UTF8;
+      case 'Z': return TYPE_LARGE_BINARY;
+      case 'U': return TYPE_LARGE_UTF8;
+      default: break;
+      }
+    } else if (format == "+l") {
+      return TYPE_LIST;
+    } else if (format == "+L") {
+      return TYPE_LARGE_LIST;
+    } else if (format == "+s") {
+      return TYPE_STRUCT;
+    } else if (format == "+m") {
+      type->add_scalar<uint8_t>(0, (field.flags & ARROW_FLAG_MAP_KEYS_SORTED) != 0);
+      return TYPE_MAP;
+    } else if (format.substr(0, 3) == "+w:") {
+      type->add_scalar<int32_t>(0, atoi(format.c_str() + 3));
+      return TYPE_FIXED_SIZE_LIST;
+    } else if (format.substr(0, 2) == "w:") {
+      type->add_scalar<int32_t>(0, atoi(format.c_str() + 2));
+      return TYPE_FIXED_SIZE_BINARY;
+    } else if (format.substr(0, 2) == "d:") {
+      int precision = 0;
+      int scale = 0;
+      int bit_width = 128;
+      if (sscanf(format.c_str() + 2, "%d,%d,%d", &precision, &scale, &bit_width) < 2) {
+        throw util::Exception("Invalid decimal format string '%s'", format.c_str());
+      }
+      type->add_scalar<int32_t>(0, precision);
+      type->add_scalar<int32_t>(1, scale);
+      type->add_scalar<int32_t>(2, bit_width);
+      return TYPE_DECIMAL;
+    } else if (format == "tdD" || format == "tdm") {
+      type->add_scalar<int16_t>(0, format[2] == 'D' ? 0 : 1);
+      return TYPE_DATE;
+    } else if (format.size() == 3 && format.substr(0, 2) == "tt") {
+      type->add_scalar<int16_t>(0, time_unit(format[2]));
+      type->add_scalar<int32_t>(1, (format[2] == 's' || format[2] == 'm') ? 32 : 64);
+      return TYPE_TIME;
+    } else if (format.size() >= 4 && format.substr(0, 2) == "ts" && format[3] == ':') {
+      type->add_scalar<int16_t>(0, time_unit(format[2]));
+      if (format.size() > 4) {
+        type->add_child(1, internal::FlatbufferNode::string(format.substr(4)));
+      }
+      return TYPE_TIMESTAMP;
+    } else if (format.size() == 3 && format.substr(0, 2) == "tD") {
+      type->add_scalar<int16_t>(0, time_unit(format[2]));
+      return TYPE_DURATION;
+    } else if (format == "tiM" || format == "tiD" || format == "tin") {
+      type->add_scalar<int16_t>(0, format[2] == 'M' ? 0 : (format[2] == 'D' ? 1 : 2));
+      return TYPE_INTERVAL;
+    } else if (format.substr(0, 4) == "+ud:" || format.substr(0, 4) == "+us:") {
+      std::string type_ids;
+      const char* item = format.c_str() + 4;
+      int64_t n_type_ids = 0;
+      while (*item != '\0') {
+        int32_t type_id = atoi(item);
+        type_ids.append(reinterpret_cast<const char*>(&type_id), sizeof(int32_t));
+        n_type_ids++;
+        item = strchr(item, ',');
+        if (item == nullptr) {
+          break;
+        }
+        item++;
+      }
+
+      type->add_scalar<int16_t>(0, format[2] == 'd' ? 1 : 0);
+      type->add_child(1, internal::FlatbufferNode::struct_vector(type_ids, n_type_ids, 4));
+      return TYPE_UNION;
+    }
+
+    throw util::Exception("Can't write field with format '%s' to IPC", format.c_str());
+  }
+
+  // The size in bytes of an element of a fixed-width type or -1
+  static int64_t format_byte_width(const std::string& format) {
+    if (format.size() == 1) {
+      switch (format[0]) {
+      case 'c': case 'C': return 1;
+      case 's': case 'S': case 'e': return 2;
+      case 'i': case 'I': case 'f': return 4;
+      case 'l': case 'L': case 'g': return 8;
+      default: return -1;
+      }
+    } else if (format.substr(0, 2) == "w:") {
+      return atoi(format.c_str() + 2);
+    } else if (format.substr(0, 2) == "d:") {
+      int precision, scale;
+      int bit_width = 128;
+      sscanf(format.c_str() + 2, "%d,%d,%d", &precision, &scale, &bit_width);
+      return bit_width / 8;
+    } else if (format == "tdD" || format == "tts" || format == "ttm" || format == "tiM") {
+      return 4;
+    } else if (format == "tdm" || format == "ttu" || format == "ttn" || format == "tiD" ||
+               format.substr(0, 2) == "ts" || format.substr(0, 2) == "tD") {
+      return 8;
+    } else if (format == "tin") {
+      return 16;
+    } else {
+      return -1;
+    }
+  }
+
+  // Collects the field nodes, buffer locations, and body buffers for a
+  // record batch by walking arrays depth-first. Slices are represented
+  // as an absolute offset into the buffers of an array and a length.
+  class BatchWriter {
+  public:
+    std::string nodes;
+    std::string buffers;
+    std::vector<internal::IOBuffer> body;
+    int64_t body_length;
+
+    BatchWriter(): body_length(0) {}
+
+    void write_array(const internal::FieldInfo& field, const struct ArrowArray* array,
+                     int64_t offset, int64_t length) {
+      const std::string& format = field.format;
+      if (array->n_children != static_cast<int64_t>(field.children.size())) {
+        throw util::Exception(
+          "Expected array with %ld children for format '%s' but got %ld children",
+          (long) field.children.size(), format.c_str(), (long) array->n_children);
+      }
+
+      if (format == "n") {
+        write_node(length, length);
+        return;
+      }
+
+      if (format.substr(0, 2) == "+u") {
+        write_node(length, 0);
+        write_buffer(array->buffers[0], offset, length);
+        if (format[2] == 'd') {
+          write_buffer(array->buffers[1], offset * 4, length * 4);
+          for (int64_t i = 0; i < array->n_children; i++) {
+            const struct ArrowArray* child = array->children[i];
+            write_array(field.children[i], child, child->offset, child->length);
+          }
+        } else {
+          write_children(field, array, offset, length);
+        }
+        return;
+      }
+
+      const uint8_t* validity = reinterpret_cast<const uint8_t*>(array->buffers[0]);
+      int64_t null_count = 0;
+      if (validity != nullptr) {
+        if (array->null_count >= 0 && offset == array->offset && length == array->length) {
+          null_count = array->null_count;
+        } else {
+          null_count = length - count_set_bits(validity, offset, length);
+        }
+      }
+
+      write_node(length, null_count);
+      if (null_count == 0) {
+        write_buffer(nullptr, 0, 0);
+      } else {
+        write_bitmap(validity, offset, length);
+      }
+
+      int64_t byte_width = format_byte_width(format);
+      if (byte_width > 0) {
+        write_buffer(array->buffers[1], offset * byte_width, length * byte_width);
+      } else if (format == "b") {
+        write_bitmap(reinterpret_cast<const uint8_t*>(array->buffers[1]), offset, length);
+      } else if (format == "z" || format == "u") {
+        int64_t start, end;
+        write_offsets<int32_t>(array->buffers[1], offset, length, &start, &end);
+        write_buffer(array->buffers[2], start, end - start);
+      } else if (format == "Z" || format == "U") {
+        int64_t start, end;
+        write_offsets<int64_t>(array->buffers[1], offset, length, &start, &end);
+        write_buffer(array->buffers[2], start, end - start);
+      } else if (format == "+l" || format == "+m" || format == "+L") {
+        int64_t start, end;
+        if (format == "+L") {
+          write_offsets<int64_t>(array->buffers[1], offset, length, &start, &end);
+        } else {
+          write_offsets<int32_t>(array->buffers[1], offset, length, &start, &end);
+        }
+
+        const struct ArrowArray* child = array->children[0];
+        write_array(field.children[0], child, child->offset + start, end - start);
+      } else if (format.substr(0, 3) == "+w:") {
+        int64_t list_size = atoi(format.c_str() + 3);
+        const struct ArrowArray* child = array->children[0];
+        write_array(field.children[0], child, child->offset + offset * list_size,
+                    length * list_size);
+      } else if (format == "+s") {
+        write_children(field, array, offset, length);
+      } else {
+        throw util::Exception("Can't write array with format '%s' to IPC", format.c_str());
+      }
+    }
+
+  private:
+    // Owns shifted bitmaps and rebased offsets
+    std::vector<std::vector<uint8_t>> scratch_;
+
+    void write_children(const internal::FieldInfo& field, const struct ArrowArray* array,
+                        int64_t offset, int64_t length) {
+      for (int64_t i = 0; i < array->n_children; i++) {
+        const struct ArrowArray* child = array->children[i];
+        write_array(field.children[i], child, child->offset + offset, length);
+      }
+    }
+
+    void write_node(int64_t length, int64_t null_count) {
+      // struct FieldNode { length: long; null_count: long; }
+      nodes.append(reinterpret_cast<const char*>(&length), sizeof(int64_t));
+      nodes.append(reinterpret_cast<const char*>(&null_count), sizeof(int64_t));
+    }
+
+    void write_buffer(const void* data, int64_t offset, int64_t size) {
+      static const uint8_t padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+
+      if (data == nullptr || size <= 0) {
+        data = nullptr;
+        size = 0;
+      }
+
+      // struct Buffer { offset: long; length: long; }
+      buffers.append(reinterpret_cast<const char*>(&body_length), sizeof(int64_t));
+      buffers.append(reinterpret_cast<const char*>(&size), sizeof(int64_t));
+
+      if (size > 0) {
+        body.push_back({reinterpret_cast<const uint8_t*>(data) + offset, size});
+      }
+
+      int64_t n_padding = padded_size(size) - size;
+      if (n_padding > 0) {
+        body.push_back({padding, n_padding});
+      }
+
+      body_length += size + n_padding;
+    }
+
+    void write_bitmap(const uint8_t* bitmap, int64_t offset, int64_t length) {
+      int64_t n_bytes = (length + 7) / 8;
+      if ((offset % 8) == 0) {
+        write_buffer(bitmap, offset / 8, n_bytes);
+        return;
+      }
+
+      std::vector<uint8_t> shifted(n_bytes, 0);
+      for (int64_t i = 0; i < length; i++) {
+        if (get_bit(bitmap, offset + i)) {
+          shifted[i / 8] |= 1 << (i % 8);
+        }
+      }
+
+      scratch_.push_back(std::move(shifted));
+      write_buffer(scratch_.back().data(), 0, n_bytes);
+    }
+
+    // Writes offsets for elements [offset, offset + length), rebasing them to
+    // start at zero if needed. Sets *start and *end to the range of child
+    // elements (or bytes) that the offsets refer to.
+    template <typename OffsetT>
+    void write_offsets(const void* data, int64_t offset, int64_t length,
+                       int64_t* start, int64_t* end) {
+      const OffsetT* offsets = reinterpret_cast<const OffsetT*>(data);
+      if (offsets == nullptr) {
+        *start = 0;
+        *end = 0;
+        write_buffer(nullptr, 0, 0);
+        return;
+      }
+
+      *start = offsets[offset];
+      *end = offsets[offset + length];
+      int64_t n_bytes = (length + 1) * sizeof(OffsetT);
+
+      if (*start == 0) {
+        write_buffer(offsets, offset * sizeof(OffsetT), n_bytes);
+        return;
+      }
+
+      std::vector<uint8_t> rebased(n_bytes);
+      OffsetT* rebased_offsets = reinterpret_cast<OffsetT*>(rebased.data());
+      for (int64_t i = 0; i <= length; i++) {
+        rebased_offsets[i] = offsets[offset + i] - *start;
+      }
+
+      scratch_.push_back(std::move(rebased));
+      write_buffer(scratch_.back().data(), 0, n_bytes);
+    }
+
+    static bool get_bit(const uint8_t* bitmap, int64_t i) {
+      return (bitmap[i / 8] & (1 << (i % 8))) != 0;
+    }
+
+    static int64_t count_set_bits(const uint8_t* bitmap, int64_t offset, int64_t length) {
+      int64_t count = 0;
+      for (int64_t i = 0; i < length; i++) {
+        count += get_bit(bitmap, offset + i);
+      }
+
+      return count;
+    }
+  };
+};
+
+}
+
+}
+
+}
@@ -262,6 +262,35 @@ static inline char* schema_metadata_create(const std::vector<std::string>& names
     return metadata;
 }
 
+// Adds key to (or replaces key in) schema->metadata, which must be nullptr
+// or allocated with malloc()
+static inline void schema_set_metadata_key(struct ArrowSchema* schema, const std::string& key,
+                                           const std::string& value) {
+  std::vector<std::string> names = schema_metadata_names(schema->metadata);
+  std::vector<std::string> values;
+  bool found = false;
+  for (const std::string& name: names) {
+    if (name == key) {
+      values.push_back(value);
+      found = true;
+    } else {
+      values.push_back(schema_metadata_key(schema->metadata, name));
+    }
+  }
+
+  if (!found) {
+    names.push_back(key);
+    values.push_back(value);
+  }
+
+  char* metadata = schema_metadata_create(names, values);
+  if (schema->metadata != nullptr) {
+    free((void*) schema->metadata);
+  }
+
+  schema->metadata = metadata;
+}
+
 static inline bool schema_format_identical(struct ArrowSchema* actual, struct ArrowSchema* expected) {
   if (strcmp(actual->format, expected->format) != 0) {
     return false;
@@ -409,7 +438,7 @@ static inline void schema_deep_copy(struct ArrowSchema* schema_in, struct ArrowS
       throw util::Exception("Failed malloc (struct ArrowSchema*)");
     }
 
-    schema_in->release = nullptr;
+    finalizer.schema.dictionary->release = nullptr;
     schema_deep_copy(schema_in->dictionary, finalizer.schema.dictionary);
   }
 
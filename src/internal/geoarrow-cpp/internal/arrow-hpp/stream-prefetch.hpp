@@ -0,0 +1,218 @@
+
+#pragma once
+
+#include <cerrno>
+#include <condition_variable>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+
+#include "common.hpp"
+#include "schema.hpp"
+
+// An ArrowArrayStream that calls get_next() on another stream from a
+// background thread, keeping up to a fixed number of arrays ready
+// so that producing array N + 1 (e.g., decoding a Parquet row group) overlaps
+// consuming array N. Only the input's get_next() is called from the
+// background thread, so it must not call into anything that isn't
+// thread safe (e.g., the R API).
+
+extern "C" int arrow_hpp_prefetch_stream_get_schema(struct ArrowArrayStream* stream,
+                                                    struct ArrowSchema* out);
+extern "C" int arrow_hpp_prefetch_stream_get_next(struct ArrowArrayStream* stream,
+                                                  struct ArrowArray* out);
+extern "C" const char* arrow_hpp_prefetch_stream_get_last_error(struct ArrowArrayStream* stream);
+extern "C" void arrow_hpp_prefetch_stream_release(struct ArrowArrayStream* stream);
+
+namespace arrow {
+
+namespace hpp {
+
+class PrefetchStream {
+public:
+  // Takes ownership of input (i.e., input->release is set to nullptr)
+  PrefetchStream(struct ArrowArrayStream* input, int64_t queue_size):
+      queue_size_(queue_size < 1 ? 1 : queue_size), done_(false), stop_(false),
+      error_code_(0) {
+    input_ = *input;
+    input->release = nullptr;
+    schema_.release = nullptr;
+
+    // The schema is fetched up front because the input can't be used from
+    // this thread once the producer thread has started
+    int result = input_.get_schema(&input_, &schema_);
+    if (result != 0) {
+      std::string error = input_error();
+      input_.release(&input_);
+      throw util::Exception("input->get_schema() failed [%d]: %s", result, error.c_str());
+    }
+
+    try {
+      producer_ = std::thread(&PrefetchStream::produce, this);
+    } catch (std::exception& e) {
+      schema_.release(&schema_);
+      input_.release(&input_);
+      throw util::Exception("Failed to start prefetch thread: %s", e.what());
+    }
+  }
+
+  ~PrefetchStream() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      stop_ = true;
+    }
+
+    not_full_.notify_all();
+    if (producer_.joinable()) {
+      producer_.join();
+    }
+
+    for (struct ArrowArray& array_data: queue_) {
+      array_data.release(&array_data);
+    }
+
+    if (schema_.release != nullptr) {
+      schema_.release(&schema_);
+    }
+
+    input_.release(&input_);
+  }
+
+  int get_schema(struct ArrowSchema* out) {
+    try {
+      schema_deep_copy(&schema_, out);
+      return 0;
+    } catch (std::exception& e) {
+      last_error_ = e.what();
+      return ENOMEM;
+    }
+  }
+
+  int get_next(struct ArrowArray* out) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    not_empty_.wait(lock, [this] { return !queue_.empty() || done_; });
+
+    if (!queue_.empty()) {
+      *out = queue_.front();
+      queue_.pop_front();
+      lock.unlock();
+      not_full_.notify_one();
+      return 0;
+    }
+
+    // Errors are reported after all arrays produced before the error
+    if (error_code_ != 0) {
+      last_error_ = error_;
+      return error_code_;
+    }
+
+    out->release = nullptr;
+    return 0;
+  }
+
+  const char* last_error() {
+    return last_error_.c_str();
+  }
+
+  // Transfers ownership of stream to out
+  static void export_stream(std::unique_ptr<PrefetchStream> stream,
+                            struct ArrowArrayStream* out) {
+    out->get_schema = &arrow_hpp_prefetch_stream_get_schema;
+    out->get_next = &arrow_hpp_prefetch_stream_get_next;
+    out->get_last_error = &arrow_hpp_prefetch_stream_get_last_error;
+    out->release = &arrow_hpp_prefetch_stream_release;
+    out->private_data = stream.release();
+  }
+
+private:
+  struct ArrowArrayStream input_;
+  struct ArrowSchema schema_;
+  int64_t queue_size_;
+
+  std::mutex mutex_;
+  std::condition_variable not_empty_;
+  std::condition_variable not_full_;
+  std::deque<struct ArrowArray> queue_;
+  bool done_;
+  bool stop_;
+  int error_code_;
+  std::string error_;
+  std::string last_error_;
+  std::thread producer_;
+
+  std::string input_error() {
+    const char* error = input_.get_last_error(&input_);
+    return error == nullptr ? "<unknown error>" : error;
+  }
+
+  void produce() {
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mutex_);
+        not_full_.wait(lock, [this] {
+          return stop_ || static_cast<int64_t>(queue_.size()) < queue_size_;
+        });
+
+        if (stop_) {
+          break;
+        }
+      }
+
+      struct ArrowArray array_data;
+      array_data.release = nullptr;
+      int result = input_.get_next(&input_, &array_data);
+
+      std::lock_guard<std::mutex> lock(mutex_);
+      if (result != 0) {
+        error_code_ = result;
+        error_ = input_error();
+        done_ = true;
+      } else if (array_data.release == nullptr) {
+        done_ = true;
+      } else {
+        queue_.push_back(array_data);
+      }
+
+      not_empty_.notify_one();
+      if (done_) {
+        break;
+      }
+    }
+  }
+};
+
+}
+
+}
+
+#ifdef ARROW_HPP_IMPL
+
+int arrow_hpp_prefetch_stream_get_schema(struct ArrowArrayStream* stream,
+                                         struct ArrowSchema* out) {
+  auto private_data = reinterpret_cast<arrow::hpp::PrefetchStream*>(stream->private_data);
+  return private_data->get_schema(out);
+}
+
+int arrow_hpp_prefetch_stream_get_next(struct ArrowArrayStream* stream,
+                                       struct ArrowArray* out) {
+  auto private_data = reinterpret_cast<arrow::hpp::PrefetchStream*>(stream->private_data);
+  return private_data->get_next(out);
+}
+
+const char* arrow_hpp_prefetch_stream_get_last_error(struct ArrowArrayStream* stream) {
+  auto private_data = reinterpret_cast<arrow::hpp::PrefetchStream*>(stream->private_data);
+  return private_data->last_error();
+}
+
+void arrow_hpp_prefetch_stream_release(struct ArrowArrayStream* stream) {
+  if (stream == nullptr || stream->release == nullptr) {
+    return;
+  }
+
+  delete reinterpret_cast<arrow::hpp::PrefetchStream*>(stream->private_data);
+  stream->release = nullptr;
+}
+
+#endif
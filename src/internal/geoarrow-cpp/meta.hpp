@@ -1,6 +1,8 @@
 
 #pragma once
 
+#include <algorithm>
+#include <cstdlib>
 #include <cstring>
 #include <stdexcept>
 #include <cstdarg>
@@ -30,6 +32,7 @@ class Meta {
     void reset() {
         storage_type_ = util::StorageType::StorageTypeOther;
         fixed_width_ = 0;
+        n_children_ = 0;
         expected_buffers_ = -1;
         nullable_ = false;
         extension_ = util::Extension::ExtensionNone;
@@ -38,6 +41,12 @@ class Meta {
         crs_ = nullptr;
         geometry_type_ = util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
         dimensions_ = util::Dimensions::DIMENSIONS_UNKNOWN;
+        coord_type_ = util::CoordType::CoordTypeUnknown;
+        coord_storage_type_ = util::StorageType::StorageTypeNone;
+        for (int j = 0; j < 4; j++) {
+            scale_[j] = 1;
+            offset_[j] = 0;
+        }
         reset_error();
 
         memset(dim_, 0, sizeof(dim_));
@@ -55,6 +64,7 @@ class Meta {
         }
 
         nullable_ = schema->flags & ARROW_FLAG_NULLABLE;
+        n_children_ = schema->n_children;
         walk_format(schema->format);
         walk_metadata(schema->metadata);
         return schema_valid(schema);
@@ -106,14 +116,58 @@ class Meta {
                         "geoarrow.point has an invalid child schema");
                     return false;
                 }
-                if (child.storage_type_ != util::StorageType::Float64) {
-                    set_error("Expected child of fixed-width list geoarrow.point to have type Float64");
+                if (!is_coord_storage_type(child.storage_type_)) {
+                    set_error("Expected child of fixed-width list geoarrow.point to have type Float64, Float32, Int32, or Int16");
+                    return false;
+                }
+                coord_type_ = util::CoordType::Interleaved;
+                coord_storage_type_ = child.storage_type_;
+                break;
+            case util::StorageType::Struct:
+                if (schema->n_children < 2 || schema->n_children > 4) {
+                    set_error(
+                        "Expected struct geoarrow.point to have between 2 and 4 children but found %lld",
+                        schema->n_children);
+                    return false;
+                }
+
+                // One child per dimension named x, y, z, or m
+                for (int64_t i = 0; i < schema->n_children; i++) {
+                    const char* name = schema->children[i]->name;
+                    if (name == nullptr || strlen(name) != 1) {
+                        set_error("Expected child %lld of struct geoarrow.point to have a one-character name", i);
+                        return false;
+                    }
+
+                    dim_[i] = name[0];
+                    if (!child.set_schema(schema->children[i])) {
+                        set_child_error(
+                            child.error_,
+                            "geoarrow.point has an invalid child schema");
+                        return false;
+                    }
+                    if (!is_coord_storage_type(child.storage_type_)) {
+                        set_error("Expected children of struct geoarrow.point to have type Float64, Float32, Int32, or Int16");
+                        return false;
+                    }
+                    if (i > 0 && child.storage_type_ != coord_storage_type_) {
+                        set_error("Expected children of struct geoarrow.point to have the same type");
+                        return false;
+                    }
+                    coord_storage_type_ = child.storage_type_;
+                }
+
+                dimensions_ = dimensions_from_dim(dim_);
+                if (dimensions_ == util::Dimensions::DIMENSIONS_UNKNOWN) {
+                    set_error("Expected struct geoarrow.point with children x, y, [z], [m] but found '%s'", dim_);
                     return false;
                 }
+                fixed_width_ = schema->n_children;
+                coord_type_ = util::CoordType::Separate;
                 break;
             default:
                 set_error(
-                    "Expected geoarrow.point to be a fixed-width list but found '%s'",
+                    "Expected geoarrow.point to be a fixed-width list or struct but found '%s'",
                     schema->format);
                 return false;
             }
@@ -122,6 +176,7 @@ class Meta {
             geometry_type_ = util::GeometryType::LINESTRING;
             switch (storage_type_) {
             case util::StorageType::List:
+            case util::StorageType::LargeList:
                 if (!child.set_schema(schema->children[0])) {
                     set_child_error(
                         child.error_,
@@ -135,6 +190,7 @@ class Meta {
                 }
 
                 dimensions_ = child.dimensions_;
+                inherit_coords(child);
                 crs_size_ = child.crs_size_;
                 crs_ = child.crs_;
                 if (edges_ == util::Edges::EdgesUnknown) {
@@ -144,7 +200,7 @@ class Meta {
 
             default:
                 set_error(
-                    "Expected geoarrow.linestring to be a list but found '%s'",
+                    "Expected geoarrow.linestring to be a list or large list but found '%s'",
                     schema->format);
                 return false;
             }
@@ -155,6 +211,7 @@ class Meta {
             geometry_type_ = util::GeometryType::POLYGON;
             switch (storage_type_) {
             case util::StorageType::List:
+            case util::StorageType::LargeList:
                 if (!child.set_schema(schema->children[0])) {
                     set_child_error(
                         child.error_,
@@ -162,9 +219,10 @@ class Meta {
                     return false;
                 }
 
-                if (child.storage_type_ != util::StorageType::List) {
+                if (child.storage_type_ != util::StorageType::List &&
+                        child.storage_type_ != util::StorageType::LargeList) {
                     set_error(
-                        "Expected child of a geoarrow.polygon to be a list but found '%s'",
+                        "Expected child of a geoarrow.polygon to be a list or large list but found '%s'",
                         schema->children[0]->format);
                     return false;
                 }
@@ -182,6 +240,7 @@ class Meta {
                 }
 
                 dimensions_ = child.dimensions_;
+                inherit_coords(child);
                 crs_size_ = child.crs_size_;
                 crs_ = child.crs_;
                 if (edges_ == util::Edges::EdgesUnknown) {
@@ -191,7 +250,7 @@ class Meta {
 
             default:
                 set_error(
-                    "Expected geoarrow.polygon to be a list but found '%s'",
+                    "Expected geoarrow.polygon to be a list or large list but found '%s'",
                     schema->format);
                 return false;
             }
@@ -204,6 +263,7 @@ class Meta {
         case util::Extension::GeometryCollection:
         switch (storage_type_) {
             case util::StorageType::List:
+            case util::StorageType::LargeList:
                 if (!child.set_schema(schema->children[0])) {
                     set_child_error(
                         child.error_,
@@ -228,6 +288,7 @@ class Meta {
                 }
 
                 dimensions_ = child.dimensions_;
+                inherit_coords(child);
                 crs_size_ = child.crs_size_;
                 crs_ = child.crs_;
                 edges_ = child.edges_;
@@ -235,13 +296,68 @@ class Meta {
 
             default:
                 set_error(
-                    "Expected geoarrow.geometrycollection to be a list but found '%s'",
+                    "Expected geoarrow.geometrycollection to be a list or large list but found '%s'",
                     schema->format);
                 return false;
             }
 
             break;
 
+        case util::Extension::Geometry:
+            geometry_type_ = util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
+            if (storage_type_ != util::StorageType::DenseUnion) {
+                set_error(
+                    "Expected geoarrow.geometry to be a dense union but found '%s'",
+                    schema->format);
+                return false;
+            }
+
+            if (schema->n_children < 1) {
+                set_error("Expected geoarrow.geometry to have at least one child");
+                return false;
+            }
+
+            for (int64_t i = 0; i < schema->n_children; i++) {
+                if (!child.set_schema(schema->children[i])) {
+                    set_child_error(
+                        child.error_,
+                        "geoarrow.geometry child has an invalid schema");
+                    return false;
+                }
+
+                switch (child.extension_) {
+                case util::Extension::Point:
+                case util::Extension::Linestring:
+                case util::Extension::Polygon:
+                case util::Extension::MultiPoint:
+                case util::Extension::MultiLinestring:
+                case util::Extension::MultiPolygon:
+                    break;
+                default:
+                    set_error(
+                        "Children of geoarrow.geometry must be a geoarrow.point, geoarrow.linestring, geoarrow.polygon, or a multi type of one of these");
+                    return false;
+                }
+
+                // The coordinate layout and crs are those of the first child
+                // (points have no edges); dimensions are only known if all
+                // children agree
+                if (i == 0) {
+                    dimensions_ = child.dimensions_;
+                    inherit_coords(child);
+                    crs_size_ = child.crs_size_;
+                    crs_ = child.crs_;
+                } else if (child.dimensions_ != dimensions_) {
+                    dimensions_ = util::Dimensions::DIMENSIONS_UNKNOWN;
+                }
+
+                if (child.edges_ != util::Edges::EdgesUnknown) {
+                    edges_ = child.edges_;
+                }
+            }
+
+            break;
+
         case util::Extension::WKB:
             geometry_type_ = util::GeometryType::GEOMETRY_TYPE_UNKNOWN;
 
@@ -299,6 +415,22 @@ class Meta {
                 return false;
             }
             break;
+        case util::StorageType::DenseUnion:
+            if (array->n_children != n_children_) {
+                set_error(
+                    "Expected dense union array to have %lld children but found %lld",
+                    n_children_, array->n_children);
+                return false;
+            }
+            break;
+        case util::StorageType::Struct:
+            if (coord_type_ == util::CoordType::Separate && array->n_children != fixed_width_) {
+                set_error(
+                    "Expected struct geoarrow.point array to have %lld children but found %lld",
+                    fixed_width_, array->n_children);
+                return false;
+            }
+            break;
         default:
             break;
         }
@@ -320,6 +452,14 @@ class Meta {
             storage_type_ = util::StorageType::Float64;
             expected_buffers_ = 2;
             break;
+        case 's':
+            storage_type_ = util::StorageType::Int16;
+            expected_buffers_ = 2;
+            break;
+        case 'i':
+            storage_type_ = util::StorageType::Int32;
+            expected_buffers_ = 2;
+            break;
         case 'u':
             storage_type_ = util::StorageType::String;
             expected_buffers_ = 3;
@@ -360,6 +500,15 @@ class Meta {
                 storage_type_ = util::StorageType::Struct;
                 expected_buffers_ = 1;
                 break;
+            case 'u':
+                // Unions have no validity buffer
+                if (format[2] == 'd') {
+                    storage_type_ = util::StorageType::DenseUnion;
+                    expected_buffers_ = 2;
+                } else {
+                    storage_type_ = util::StorageType::StorageTypeOther;
+                }
+                break;
             }
         }
     }
@@ -390,7 +539,9 @@ class Meta {
                 const char* value = metadata + pos;
                 pos += value_len;
 
-                if (value_len >= 14 && strncmp(value, "geoarrow.point", 14) == 0) {
+                if (value_len == 17 && strncmp(value, "geoarrow.geometry", 17) == 0) {
+                    extension_ = util::Extension::Geometry;
+                } else if (value_len >= 14 && strncmp(value, "geoarrow.point", 14) == 0) {
                     extension_ = util::Extension::Point;
                 } else if (value_len >= 19 && strncmp(value, "geoarrow.linestring", 19) == 0) {
                     extension_ = util::Extension::Linestring;
@@ -444,6 +595,10 @@ class Meta {
                         } else if (value_len >= 11 && strncmp(value, "ellipsoidal", 11) == 0) {
                             edges_ = util::Edges::Ellipsoidal;
                         }
+                    } else if (name_len == 5 && strncmp(name, "scale", 5) == 0) {
+                        parse_per_dimension(value, value_len, scale_);
+                    } else if (name_len == 6 && strncmp(name, "offset", 6) == 0) {
+                        parse_per_dimension(value, value_len, offset_);
                     }
                 }
             } else {
@@ -469,6 +624,7 @@ class Meta {
 
     util::StorageType storage_type_;
     int64_t fixed_width_;
+    int64_t n_children_;
     int32_t expected_buffers_;
     bool nullable_;
 
@@ -480,11 +636,65 @@ class Meta {
 
     util::GeometryType geometry_type_;
     util::Dimensions dimensions_;
+    util::CoordType coord_type_;
+    util::StorageType coord_storage_type_;
+
+    // Integer coordinates are stored as (value - offset) / scale, with the
+    // scale and offset given by the "scale" and "offset" keys of the point's
+    // extension metadata. Each is either one number for all dimensions or
+    // one space-separated number per dimension.
+    double scale_[4];
+    double offset_[4];
 
     char error_[1024];
 
 private:
 
+    static bool is_coord_storage_type(util::StorageType storage_type) {
+        switch (storage_type) {
+        case util::StorageType::Float64:
+        case util::StorageType::Float32:
+        case util::StorageType::Int32:
+        case util::StorageType::Int16:
+            return true;
+        default:
+            return false;
+        }
+    }
+
+    void inherit_coords(const Meta& child) {
+        coord_type_ = child.coord_type_;
+        coord_storage_type_ = child.coord_storage_type_;
+        memcpy(scale_, child.scale_, sizeof(scale_));
+        memcpy(offset_, child.offset_, sizeof(offset_));
+    }
+
+    // !! value is not null-terminated
+    static void parse_per_dimension(const char* value, int32_t value_len, double* out) {
+        char buf[128];
+        int32_t n_copy = std::min<int32_t>(value_len, sizeof(buf) - 1);
+        memcpy(buf, value, n_copy);
+        buf[n_copy] = '\0';
+
+        char* cursor = buf;
+        char* end;
+        int n = 0;
+        while (n < 4) {
+            double item = strtod(cursor, &end);
+            if (end == cursor) {
+                break;
+            }
+
+            out[n++] = item;
+            cursor = end;
+        }
+
+        // A single value applies to all dimensions
+        for (int j = n; n == 1 && j < 4; j++) {
+            out[j] = out[0];
+        }
+    }
+
     int set_error(const char* fmt, ...) {
         memset(error_, 0, sizeof(error_));
         va_list args;
@@ -1,6 +1,7 @@
 
 #pragma once
 
+#include <string>
 #include <vector>
 
 #include "internal/arrow-hpp/schema.hpp"
@@ -10,6 +11,12 @@ namespace geoarrow {
 class Metadata {
 public:
 
+    Metadata& set(const std::string& name, const std::string& value) {
+        names_.push_back(name);
+        values_.push_back(value);
+        return *this;
+    }
+
     std::string build() {
         char* metadata = arrow::hpp::schema_metadata_create(names_, values_);
         std::string out(metadata, arrow::hpp::schema_metadata_size(metadata));
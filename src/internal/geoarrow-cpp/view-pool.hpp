@@ -0,0 +1,213 @@
+
+#pragma once
+
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include "array-view-base.hpp"
+#include "factory.hpp"
+#include "instrument.hpp"
+#include "internal/arrow-hpp/schema.hpp"
+
+namespace geoarrow {
+
+// An ArrayView and the copy of the schema it was created from. The view
+// only refers to this copy (never to the caller's schema), so it can be
+// reused by any later caller whose schema is identical.
+class PooledView {
+  public:
+    PooledView(struct ArrowSchema* schema, uint64_t fingerprint): fingerprint_(fingerprint) {
+        schema_.release = nullptr;
+        arrow::hpp::schema_deep_copy(schema, &schema_);
+        try {
+            copy_flags(schema, &schema_);
+            view_.reset(create_view(&schema_));
+        } catch (std::exception& e) {
+            schema_.release(&schema_);
+            throw;
+        }
+    }
+
+    ~PooledView() {
+        view_.reset();
+        if (schema_.release != nullptr) {
+            schema_.release(&schema_);
+        }
+    }
+
+    ArrayView* view() { return view_.get(); }
+
+    uint64_t fingerprint_;
+    struct ArrowSchema schema_;
+
+  private:
+    std::unique_ptr<ArrayView> view_;
+
+    // schema_deep_copy() doesn't copy flags but the Meta of some views
+    // depends on them
+    static void copy_flags(const struct ArrowSchema* schema_in, struct ArrowSchema* schema_out) {
+        schema_out->flags = schema_in->flags;
+        for (int64_t i = 0; i < schema_in->n_children; i++) {
+            copy_flags(schema_in->children[i], schema_out->children[i]);
+        }
+
+        if (schema_in->dictionary != nullptr) {
+            copy_flags(schema_in->dictionary, schema_out->dictionary);
+        }
+    }
+};
+
+// A process-wide pool of views that have been used before, keyed by a
+// fingerprint of their schema. Creating a view parses its schema (and the
+// schema of each child view) into a Meta, which dominates the cost of
+// many small compute or handle calls on arrays of the same type. A view is
+// removed from the pool by acquire() and is only reused once it is passed
+// back to release(), so nested calls with the same schema never share a view.
+class ViewPool {
+  public:
+    ViewPool(size_t capacity = 16): capacity_(capacity) {}
+
+    // Returns a view of schema that is owned by the caller until it is passed
+    // to release() (or deleted). The view's array must be set before use.
+    PooledView* acquire(struct ArrowSchema* schema) {
+        uint64_t fingerprint = schema_fingerprint(schema);
+
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            for (size_t i = pool_.size(); i > 0; i--) {
+                PooledView* pooled = pool_[i - 1].get();
+                if (pooled->fingerprint_ == fingerprint &&
+                        schema_identical(schema, &pooled->schema_)) {
+                    pool_[i - 1].release();
+                    pool_.erase(pool_.begin() + (i - 1));
+                    GEOARROW_COUNT(VIEW_POOL_HITS, 1);
+                    pooled->view()->feature_id_ = -1;
+                    return pooled;
+                }
+            }
+        }
+
+        GEOARROW_COUNT(VIEW_POOL_MISSES, 1);
+        return new PooledView(schema, fingerprint);
+    }
+
+    // Takes ownership of a view returned by acquire(), dropping the least
+    // recently released view if the pool is full
+    void release(PooledView* pooled) {
+        std::unique_ptr<PooledView> evicted;
+        std::unique_ptr<PooledView> owned(pooled);
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.push_back(std::move(owned));
+        if (pool_.size() > capacity_) {
+            evicted = std::move(pool_.front());
+            pool_.erase(pool_.begin());
+        }
+    }
+
+    void clear() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        pool_.clear();
+    }
+
+    size_t size() {
+        std::lock_guard<std::mutex> lock(mutex_);
+        return pool_.size();
+    }
+
+    static ViewPool& global();
+
+    // A 64-bit FNV-1a hash of everything about a schema that a view can
+    // depend on: format, name, flags, metadata, children, and dictionary
+    static uint64_t schema_fingerprint(const struct ArrowSchema* schema,
+                                       uint64_t hash = 14695981039346656037ULL) {
+        hash = hash_string(schema->format, hash);
+        hash = hash_string(schema->name, hash);
+        hash = hash_bytes(&schema->flags, sizeof(int64_t), hash);
+        hash = hash_bytes(schema->metadata,
+                          arrow::hpp::schema_metadata_size(schema->metadata), hash);
+        hash = hash_bytes(&schema->n_children, sizeof(int64_t), hash);
+        for (int64_t i = 0; i < schema->n_children; i++) {
+            hash = schema_fingerprint(schema->children[i], hash);
+        }
+
+        if (schema->dictionary != nullptr) {
+            hash = schema_fingerprint(schema->dictionary, hash);
+        }
+
+        return hash;
+    }
+
+    // The exact comparison behind a matching fingerprint
+    static bool schema_identical(const struct ArrowSchema* lhs, const struct ArrowSchema* rhs) {
+        if (!string_identical(lhs->format, rhs->format) ||
+                !string_identical(lhs->name, rhs->name) ||
+                lhs->flags != rhs->flags ||
+                lhs->n_children != rhs->n_children ||
+                (lhs->dictionary == nullptr) != (rhs->dictionary == nullptr)) {
+            return false;
+        }
+
+        int64_t metadata_size = arrow::hpp::schema_metadata_size(lhs->metadata);
+        if (metadata_size != arrow::hpp::schema_metadata_size(rhs->metadata) ||
+                (metadata_size > 0 && memcmp(lhs->metadata, rhs->metadata, metadata_size) != 0)) {
+            return false;
+        }
+
+        for (int64_t i = 0; i < lhs->n_children; i++) {
+            if (!schema_identical(lhs->children[i], rhs->children[i])) {
+                return false;
+            }
+        }
+
+        return lhs->dictionary == nullptr ||
+            schema_identical(lhs->dictionary, rhs->dictionary);
+    }
+
+  private:
+    size_t capacity_;
+    std::mutex mutex_;
+    std::vector<std::unique_ptr<PooledView>> pool_;
+
+    static uint64_t hash_bytes(const void* data, int64_t size, uint64_t hash) {
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(data);
+        for (int64_t i = 0; i < size; i++) {
+            hash ^= bytes[i];
+            hash *= 1099511628211ULL;
+        }
+
+        return hash;
+    }
+
+    // Includes the terminating null such that nullptr, "", and adjacent
+    // strings hash differently
+    static uint64_t hash_string(const char* value, uint64_t hash) {
+        if (value == nullptr) {
+            return hash_bytes("\xff", 1, hash);
+        }
+
+        return hash_bytes(value, strlen(value) + 1, hash);
+    }
+
+    static bool string_identical(const char* lhs, const char* rhs) {
+        if (lhs == nullptr || rhs == nullptr) {
+            return lhs == rhs;
+        }
+
+        return strcmp(lhs, rhs) == 0;
+    }
+};
+
+#if defined(ARROW_HPP_IMPL)
+
+ViewPool& ViewPool::global() {
+    static ViewPool pool;
+    return pool;
+}
+
+#endif
+
+}
@@ -4,6 +4,7 @@
 #include <cmath>
 
 #include "handler.hpp"
+#include "instrument.hpp"
 
 #define EWKB_Z_BIT 0x80000000
 #define EWKB_M_BIT 0x40000000
@@ -169,6 +170,7 @@ private:
         }
         break;
       default:
+        GEOARROW_COUNT(PARSER_EXCEPTIONS, 1);
         throw util::IOException("Unrecognized geometry type: %d", geometry_type);
       }
 
@@ -181,6 +183,7 @@ private:
       Handler::Result result;
 
       if (swapping_) {
+        GEOARROW_COUNT(WKB_SWAPS, static_cast<int64_t>(n) * coord_size);
         uint64_t tmp;
         for (uint32_t i = 0; i < n; i++) {
           for (int32_t j = 0; j < coord_size; j++) {
@@ -216,6 +219,7 @@ private:
       check_buffer(sizeof(uint32_t));
       uint32_t result = read<uint32_t>();
       if (swapping_) {
+        GEOARROW_COUNT(WKB_SWAPS, 1);
         return(bswap_32(result));
       } else {
         return result;
@@ -229,6 +233,7 @@ private:
 
     void check_buffer(int64_t n) {
       if ((offset_ + n) > size_) {
+        GEOARROW_COUNT(PARSER_EXCEPTIONS, 1);
         throw util::IOException(
             "Unexpected end of buffer at %lld + %lld / %lld",
              offset_, n, size_);
@@ -6,6 +6,7 @@
 #include <cstdlib>
 
 #include "handler.hpp"
+#include "instrument.hpp"
 
 #ifdef FASTFLOAT_FAST_FLOAT_H
 #define _GEOARROW_FROM_CHARS(first, last, out) fast_float::from_chars(first, last, out)
@@ -486,6 +487,7 @@ public:
       s.assertFinished();
       return Handler::Result::CONTINUE;
     } catch(util::ParserException& e) {
+      GEOARROW_COUNT(PARSER_EXCEPTIONS, 1);
       throw util::IOException("%s", e.what());
     }
   }
@@ -16,6 +16,18 @@ void geoarrow_finalize_array_data(SEXP array_data_xptr) {
     }
 }
 
+void geoarrow_finalize_array_stream(SEXP array_stream_xptr) {
+    struct ArrowArrayStream* array_stream =
+        (struct ArrowArrayStream*) R_ExternalPtrAddr(array_stream_xptr);
+    if (array_stream != nullptr && array_stream->release != nullptr) {
+        array_stream->release(array_stream);
+    }
+
+    if (array_stream != nullptr) {
+      free(array_stream);
+    }
+}
+
 void delete_array_view_xptr(SEXP array_view_xptr) {
     geoarrow::ArrayView* array_view =
         reinterpret_cast<geoarrow::ArrayView*>(R_ExternalPtrAddr(array_view_xptr));
@@ -25,6 +37,15 @@ void delete_array_view_xptr(SEXP array_view_xptr) {
     }
 }
 
+void delete_pooled_view_xptr(SEXP pooled_view_xptr) {
+    geoarrow::PooledView* pooled_view =
+        reinterpret_cast<geoarrow::PooledView*>(R_ExternalPtrAddr(pooled_view_xptr));
+
+    if (pooled_view != nullptr) {
+        delete pooled_view;
+    }
+}
+
 void delete_array_builder_xptr(SEXP array_builder_xptr) {
     geoarrow::ComputeBuilder* array_builder =
         reinterpret_cast<geoarrow::ComputeBuilder*>(R_ExternalPtrAddr(array_builder_xptr));
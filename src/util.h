@@ -18,7 +18,9 @@
     return R_NilValue;
 
 void geoarrow_finalize_array_data(SEXP array_data_xptr);
+void geoarrow_finalize_array_stream(SEXP array_stream_xptr);
 void delete_array_view_xptr(SEXP array_view_xptr);
+void delete_pooled_view_xptr(SEXP pooled_view_xptr);
 void delete_array_builder_xptr(SEXP array_builder_xptr);
 void delete_compute_options_xptr(SEXP compute_options_xptr);
 